@@ -0,0 +1,239 @@
+/* Chess --- batch.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "batch.h"
+#include "chessBot.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <omp.h>
+
+using namespace BoardFunctions;
+using namespace std::chrono;
+
+namespace {
+    // A position of the input, with its line number and EPD id
+    struct BatchPosition {
+        int line;
+        string fen;
+        string id;
+    };
+
+    // Result of the search of a position
+    struct BatchResult {
+        Move move;
+
+        // Score from the point of view of the side to move
+        int score;
+        int depth;
+        uint64_t nodes;
+        int64_t milliseconds;
+
+        // The move is from the opening book
+        bool book;
+
+        // Line the search expects, starting with the move
+        vector<Move> pv;
+
+        // Lines of the best moves, best first, with the scores
+        // from the point of view of the side to move
+        vector<RootLine> lines;
+    };
+
+    // Reads the next position, skipping empty lines and # comments
+    // EPD lines keep their operations after the four position fields,
+    // only the id operation is used, the FEN move counters are ignored
+    bool readPosition(istream& input, int& lineNumber, BatchPosition& position) {
+        string line;
+        while (getline(input, line)) {
+            lineNumber++;
+            if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == string::npos) continue;
+
+            position = {lineNumber, line, ""};
+            const size_t id = line.find(" id ");
+            if (id != string::npos) {
+                const size_t first = line.find('"', id);
+                const size_t last = first == string::npos ? first : line.find('"', first + 1);
+                if (last != string::npos) position.id = line.substr(first + 1, last - first - 1);
+            }
+
+            // Keep only the position fields, the rest are EPD operations or counters
+            istringstream stream(line);
+            string field;
+            position.fen.clear();
+            for (int i = 0; i < 4 && stream >> field; i++) position.fen += (i ? " " : "") + field;
+            return true;
+        }
+        return false;
+    }
+
+    string escapeJson(const string& text) {
+        string escaped;
+        for (const char c : text) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+        }
+        return escaped;
+    }
+
+    string escapeCsv(const string& text) {
+        string escaped = "\"";
+        for (const char c : text) {
+            if (c == '"') escaped += '"';
+            escaped += c;
+        }
+        return escaped + "\"";
+    }
+
+    string formatResult(const BatchPosition& position, const BatchResult& result, const bool csv,
+                        const int multiPv) {
+        const string move = result.move == NO_MOVE ? "none" : convertMoveToNotation(result.move);
+        const int mate = movesToMate(result.score);
+        ostringstream line;
+
+        // A pawn is 10 in the evaluation and 100 centipawns
+        // A finished game has no lines, and is written like a single one
+        if (csv && multiPv > 1 && !result.lines.empty()) {
+            for (size_t i = 0; i < result.lines.size(); i++) {
+                const RootLine& rootLine = result.lines[i];
+                line << (i ? "\n" : "") << position.line << "," << escapeCsv(position.id) << ","
+                     << escapeCsv(position.fen) << "," << convertMoveToNotation(rootLine.pv[0]) << ","
+                     << rootLine.score * 10 << "," << movesToMate(rootLine.score) << "," << result.depth << ","
+                     << result.nodes << "," << result.milliseconds << "," << (result.book ? 1 : 0) << ","
+                     << convertLineToNotation(rootLine.pv) << "," << i + 1;
+            }
+        }
+        else if (csv) {
+            line << position.line << "," << escapeCsv(position.id) << "," << escapeCsv(position.fen) << ","
+                 << move << "," << result.score * 10 << "," << mate << "," << result.depth << ","
+                 << result.nodes << "," << result.milliseconds << "," << (result.book ? 1 : 0) << ","
+                 << convertLineToNotation(result.pv) << (multiPv > 1 ? "," : "");
+        }
+        else {
+            line << "{\"line\":" << position.line << ",\"id\":\"" << escapeJson(position.id)
+                 << "\",\"fen\":\"" << escapeJson(position.fen) << "\",\"bestmove\":\"" << move
+                 << "\",\"score\":" << result.score * 10 << ",\"mate\":" << mate
+                 << ",\"depth\":" << result.depth << ",\"nodes\":" << result.nodes
+                 << ",\"time\":" << result.milliseconds << ",\"book\":" << (result.book ? "true" : "false")
+                 << ",\"pv\":\"" << convertLineToNotation(result.pv) << "\"";
+            if (multiPv > 1) {
+                line << ",\"lines\":[";
+                for (size_t i = 0; i < result.lines.size(); i++) {
+                    const RootLine& rootLine = result.lines[i];
+                    line << (i ? "," : "") << "{\"move\":\"" << convertMoveToNotation(rootLine.pv[0])
+                         << "\",\"score\":" << rootLine.score * 10 << ",\"mate\":" << movesToMate(rootLine.score)
+                         << ",\"pv\":\"" << convertLineToNotation(rootLine.pv) << "\"}";
+                }
+                line << "]";
+            }
+            line << "}";
+        }
+        return line.str();
+    }
+
+    string formatError(const BatchPosition& position, const bool csv, const int multiPv) {
+        if (csv) return to_string(position.line) + "," + escapeCsv(position.id) + "," +
+                        escapeCsv(position.fen) + ",error,,,,,,," + (multiPv > 1 ? "," : "");
+        return "{\"line\":" + to_string(position.line) + ",\"id\":\"" + escapeJson(position.id) +
+               "\",\"fen\":\"" + escapeJson(position.fen) + "\",\"error\":\"invalid position\"}";
+    }
+}
+
+namespace Batch {
+    int run(const BatchOptions& options) {
+        ifstream file;
+        if (!options.input.empty()) {
+            file.open(options.input);
+            if (!file) {
+                cerr << "Cannot open " << options.input << endl;
+                return 1;
+            }
+        }
+        istream& input = options.input.empty() ? cin : file;
+
+        if (options.csv) {
+            cout << "line,id,fen,bestmove,score,mate,depth,nodes,time,book,pv"
+                 << (options.multiPv > 1 ? ",multipv" : "") << endl;
+        }
+
+        SearchLimits limits;
+        limits.depth = options.depth;
+        limits.milliseconds = options.milliseconds;
+        limits.multiPv = options.multiPv;
+
+        int lineNumber = 0;
+        int errors = 0;
+        uint64_t positions = 0;
+        uint64_t totalNodes = 0;
+        const auto start = steady_clock::now();
+
+        // Every worker searches its own positions with a bot of a single
+        // thread, so the workers never wait for each other inside a search.
+        // Positions are read one at a time, so the input can be a stream
+        #pragma omp parallel num_threads(options.workers) default(none) \
+            shared(options, input, limits, lineNumber, errors, positions, totalNodes, cout)
+        {
+            ChessBot chessBot(options.hashMegabytes);
+            chessBot.setThreads(1);
+            chessBot.setBook(options.book, options.bookSelection);
+            chessBot.setTablebases(options.tablebases);
+            chessBot.setNetwork(options.network);
+            chessBot.setPruning(options.pruning);
+            chessBot.setPawnHashSize(options.pawnHashKilobytes);
+
+            while (true) {
+                BatchPosition position;
+                bool found;
+                #pragma omp critical(batchInput)
+                found = readPosition(input, lineNumber, position);
+                if (!found) break;
+
+                Board board;
+                Color turn;
+                string line;
+                if (!loadFen(board, position.fen, turn)) {
+                    line = formatError(position, options.csv, options.multiPv);
+                    #pragma omp atomic
+                    errors++;
+                }
+                else {
+                    // Positions don't share anything, old entries would
+                    // only take the place of the ones of this position
+                    chessBot.clearHash();
+
+                    const auto searchStart = steady_clock::now();
+                    const auto [score, move] = chessBot.search(board, turn, limits);
+                    BatchResult result;
+                    result.move = move;
+                    result.score = turn == WHITE ? score : -score;
+                    result.depth = chessBot.completedDepth();
+                    result.nodes = chessBot.stats().nodes;
+                    result.milliseconds = duration_cast<milliseconds>(steady_clock::now() - searchStart).count();
+                    result.book = chessBot.playedFromBook();
+                    result.pv = chessBot.principalVariation();
+                    result.lines = chessBot.rootLines();
+                    line = formatResult(position, result, options.csv, options.multiPv);
+
+                    #pragma omp atomic
+                    positions++;
+                    #pragma omp atomic
+                    totalNodes += result.nodes;
+                }
+
+                // Lines are flushed one by one, so the results
+                // can be read while the run is still going
+                #pragma omp critical(batchOutput)
+                cout << line << endl;
+            }
+        }
+
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+        cerr << positions << " positions, " << errors << " invalid, " << static_cast<long>(seconds * 1000)
+             << " ms, " << static_cast<uint64_t>(positions / max(seconds, 1e-9)) << " positions/s, "
+             << static_cast<uint64_t>(totalNodes / max(seconds, 1e-9)) << " moves/s" << endl;
+        return errors;
+    }
+}
@@ -0,0 +1,71 @@
+/* Chess --- batch.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_BATCH_H
+#define CHESS_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "openingBook.h"
+#include "chessBot.h"
+#include "nnue.h"
+#include "tablebases.h"
+
+using namespace std;
+
+// Options of a batch analysis run
+struct BatchOptions {
+    // File of FEN or EPD positions, one per line,
+    // the standard input when empty
+    string input;
+
+    // Depth and time limit of every search, a zero time is not checked
+    int depth = 6;
+    int64_t milliseconds = 0;
+
+    // Positions searched at the same time, every
+    // position is searched by a single thread
+    int workers = 1;
+
+    // Transposition table size of every worker
+    size_t hashMegabytes = 16;
+
+    // Pawn hash table size of every worker
+    size_t pawnHashKilobytes = DEFAULT_PAWN_HASH_KB;
+
+    // Best moves every search gives a score and a line of
+    int multiPv = 1;
+
+    // Writes CSV lines instead of JSON lines
+    bool csv = false;
+
+    // Positions in the book get the book move without a search
+    const OpeningBook* book = nullptr;
+    BookSelection bookSelection = BOOK_BEST;
+
+    // Endgame tablebases probed by the searches, if any
+    const Tablebases* tablebases = nullptr;
+
+    // Network the searches evaluate with, the piece-square tables if none
+    const Network* network = nullptr;
+
+    // Parts of the selective search that are used
+    PruningOptions pruning;
+};
+
+// Namespace that holds the offline analysis of many positions
+namespace Batch {
+    // Reads the positions and searches them with the workers,
+    // each result is written as soon as its search is done,
+    // so the results may be in a different order than the input
+    // With more than one MultiPV line, a JSON result lists them all
+    // and a CSV result takes a row for each, numbered in a last column
+    // Returns the number of positions that couldn't be read
+    int run(const BatchOptions& options);
+}
+
+
+#endif //CHESS_BATCH_H
@@ -0,0 +1,86 @@
+/* Chess --- bench.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "bench.h"
+#include "chessBot.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace BoardFunctions;
+using namespace std::chrono;
+
+namespace {
+    // Openings played from the starting position, each
+    // move is the starting square followed by the target
+    const vector<vector<string>> benchPositions = {
+        {},
+        {"e2 e4", "e7 e5", "g1 f3", "b8 c6", "f1 b5", "a7 a6"},
+        {"d2 d4", "g8 f6", "c2 c4", "e7 e6", "b1 c3", "f8 b4"},
+        {"e2 e4", "c7 c5", "g1 f3", "d7 d6", "d2 d4", "c5 d4", "f3 d4", "g8 f6", "b1 c3", "a7 a6"},
+    };
+
+    // Plays the moves of a bench position
+    // Returns the color to move after them
+    Color setUpPosition(Board& board, const vector<string>& moves) {
+        populateBoard(board);
+        Color turn = WHITE;
+        for (const string& move : moves) {
+            makeMove(board, createMove(board, convertNotationToIndex(move.substr(0, 2)),
+                                       convertNotationToIndex(move.substr(3, 2))));
+            turn = turn == WHITE ? BLACK : WHITE;
+        }
+        return turn;
+    }
+}
+
+namespace Bench {
+    void run(const int depth, const int maxThreads, const size_t hashMegabytes, const Network* network,
+             const PruningOptions& pruning, const size_t pawnHashKilobytes) {
+        cout << "Depth " << depth << ", " << benchPositions.size() << " positions, "
+             << (network ? "network" : "piece-square table") << " evaluation" << endl;
+        cout << "Null move " << (pruning.nullMove ? "on" : "off") << ", late move reductions "
+             << (pruning.lateMoveReductions ? "on" : "off") << ", futility pruning "
+             << (pruning.futility ? "on" : "off") << endl << endl;
+        cout << setw(8) << "threads" << setw(12) << "time (ms)" << setw(14) << "moves"
+             << setw(14) << "moves/s" << setw(10) << "speedup";
+        if (!network) cout << setw(12) << "pawn hits";
+        cout << endl;
+
+        double baseTime = 0;
+        for (int threads = 1; ; threads = min(threads * 2, maxThreads)) {
+            // A fresh bot for every thread count, so that
+            // no run starts with a filled transposition table
+            ChessBot chessBot(hashMegabytes);
+            chessBot.setThreads(threads);
+            chessBot.setNetwork(network);
+            chessBot.setPruning(pruning);
+            chessBot.setPawnHashSize(pawnHashKilobytes);
+
+            uint64_t moves = 0;
+            HashStats pawnHash;
+            const auto start = steady_clock::now();
+            for (const auto& position : benchPositions) {
+                Board board;
+                const Color turn = setUpPosition(board, position);
+                chessBot.minimax(board, depth, turn);
+                const SearchStats stats = chessBot.stats();
+                moves += stats.nodes;
+                pawnHash += stats.pawnHash;
+            }
+            const double time = duration<double, milli>(steady_clock::now() - start).count();
+            if (threads == 1) baseTime = time;
+
+            cout << setw(8) << threads << setw(12) << static_cast<long>(time) << setw(14) << moves
+                 << setw(14) << static_cast<long>(moves / (time / 1000)) << setw(9)
+                 << fixed << setprecision(2) << baseTime / time << "x";
+            if (!network) cout << setw(11) << setprecision(1) << pawnHash.hitRate() * 100 << "%";
+            cout << endl;
+
+            if (threads >= maxThreads) break;
+        }
+    }
+}
@@ -0,0 +1,25 @@
+/* Chess --- bench.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_BENCH_H
+#define CHESS_BENCH_H
+
+#include <cstddef>
+#include "chessBot.h"
+
+// Namespace that holds the search benchmark
+namespace Bench {
+    // Searches a fixed set of positions to the given depth with
+    // 1, 2, 4 ... threads up to maxThreads, and prints the time,
+    // moves analysed and speed of every thread count
+    // The network evaluates the positions if one is given, and
+    // pruning sets the parts of the selective search that are used
+    // Without a network, the pawn hash hit rate is printed as well
+    void run(int depth, int maxThreads, size_t hashMegabytes, const Network* network, const PruningOptions& pruning,
+             size_t pawnHashKilobytes);
+}
+
+
+#endif //CHESS_BENCH_H
@@ -0,0 +1,178 @@
+/* Chess --- bitboards.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "bitboards.h"
+
+namespace Bitboards {
+    Bitboard knightTable[64];
+    Bitboard kingTable[64];
+    Bitboard pawnTable[2][64];
+    Magic rookMagics[64];
+    Magic bishopMagics[64];
+    Bitboard betweenTable[64][64];
+    Bitboard lineTable[64][64];
+}
+
+using namespace Bitboards;
+
+namespace {
+    // Storage for the sliding attacks, shared between squares
+    // Sizes are the sum of 2^(relevant bits) over all squares
+    Bitboard rookAttackTable[0x19000];
+    Bitboard bishopAttackTable[0x1480];
+
+    const int rookDirections[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+    const int bishopDirections[4][2] = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+
+    // Checks if given xy coordinates are in bounds
+    bool isInBounds(const int x, const int y) {
+        return x >= 0 && x < 8 && y >= 0 && y < 8;
+    }
+
+    // Returns the square bit of the given coordinates, or an
+    // empty bitboard when the coordinates are off the board
+    Bitboard squareAt(const int x, const int y) {
+        return isInBounds(x, y) ? squareBit(y * 8 + x) : 0;
+    }
+
+    // Walks the rays one square at a time, only used while
+    // building the tables
+    Bitboard slidingAttacks(const int square, const Bitboard occupied, const int directions[4][2]) {
+        Bitboard attacks = 0;
+        for (int i = 0; i < 4; i++) {
+            int x = square % 8 + directions[i][0];
+            int y = square / 8 + directions[i][1];
+            while (isInBounds(x, y)) {
+                attacks |= squareAt(x, y);
+                if (occupied & squareAt(x, y)) break;
+                x += directions[i][0];
+                y += directions[i][1];
+            }
+        }
+        return attacks;
+    }
+
+#ifndef CHESS_USE_PEXT
+    // Xorshift generator with a fixed seed, so the magics
+    // are found the same way on every run
+    uint64_t nextRandom(uint64_t& state) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+#endif
+
+    // Fills the magics of a slider, either by searching for a magic
+    // number that maps every occupancy without harmful collisions,
+    // or by indexing directly with PEXT when it is available
+    void initMagics(Magic magics[64], Bitboard table[], const int directions[4][2]) {
+        Bitboard occupancies[4096];
+        Bitboard references[4096];
+#ifndef CHESS_USE_PEXT
+        int epochs[4096] = {};
+        int epoch = 0;
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+#endif
+        int offset = 0;
+
+        for (int square = 0; square < 64; square++) {
+            Magic& magic = magics[square];
+
+            // Edges do not change the attacks, unless the piece is on them
+            const Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (square / 8 * 8))) |
+                                   ((FILE_A | FILE_H) & ~(FILE_A << (square % 8)));
+            magic.mask = slidingAttacks(square, 0, directions) & ~edges;
+            magic.shift = 64 - popCount(magic.mask);
+            magic.attacks = table + offset;
+
+            // Carry-rippler trick enumerates every subset of the mask
+            int size = 0;
+            Bitboard subset = 0;
+            do {
+                occupancies[size] = subset;
+                references[size] = slidingAttacks(square, subset, directions);
+#ifdef CHESS_USE_PEXT
+                magic.attacks[magic.index(occupancies[size])] = references[size];
+#endif
+                size++;
+                subset = (subset - magic.mask) & magic.mask;
+            } while (subset);
+            offset += size;
+
+#ifndef CHESS_USE_PEXT
+            // Sparse random numbers make good magic candidates
+            for (int i = 0; i < size;) {
+                magic.magic = 0;
+                while (popCount((magic.mask * magic.magic) >> 56) < 6) {
+                    magic.magic = nextRandom(seed) & nextRandom(seed) & nextRandom(seed);
+                }
+
+                epoch++;
+                for (i = 0; i < size; i++) {
+                    const unsigned index = magic.index(occupancies[i]);
+                    if (epochs[index] < epoch) {
+                        epochs[index] = epoch;
+                        magic.attacks[index] = references[i];
+                    }
+                    else if (magic.attacks[index] != references[i]) {
+                        break;
+                    }
+                }
+            }
+#endif
+        }
+    }
+
+    void initLeaperTables() {
+        const int knightOffsets[8][2] = {{1, 2}, {-1, 2}, {2, 1}, {-2, 1},
+                                         {2, -1}, {-2, -1}, {1, -2}, {-1, -2}};
+
+        for (int square = 0; square < 64; square++) {
+            const int x = square % 8;
+            const int y = square / 8;
+
+            for (const auto& offset : knightOffsets) {
+                knightTable[square] |= squareAt(x + offset[0], y + offset[1]);
+            }
+
+            for (int i = 0; i < 9; i++) {
+                if (i == 4) continue;
+                kingTable[square] |= squareAt(x + i % 3 - 1, y + i / 3 - 1);
+            }
+
+            pawnTable[0][square] = squareAt(x - 1, y + 1) | squareAt(x + 1, y + 1);
+            pawnTable[1][square] = squareAt(x - 1, y - 1) | squareAt(x + 1, y - 1);
+        }
+    }
+
+    // Needs the sliding attacks, so it runs after the magics
+    void initLineTables() {
+        for (int a = 0; a < 64; a++) {
+            for (int b = 0; b < 64; b++) {
+                if (a == b) continue;
+                const Bitboard ends = squareBit(a) | squareBit(b);
+                if (rookAttacks(a, 0) & squareBit(b)) {
+                    betweenTable[a][b] = rookAttacks(a, squareBit(b)) & rookAttacks(b, squareBit(a));
+                    lineTable[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | ends;
+                }
+                else if (bishopAttacks(a, 0) & squareBit(b)) {
+                    betweenTable[a][b] = bishopAttacks(a, squareBit(b)) & bishopAttacks(b, squareBit(a));
+                    lineTable[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | ends;
+                }
+            }
+        }
+    }
+
+    // Builds every table before main starts
+    struct Initializer {
+        Initializer() {
+            initLeaperTables();
+            initMagics(rookMagics, rookAttackTable, rookDirections);
+            initMagics(bishopMagics, bishopAttackTable, bishopDirections);
+            initLineTables();
+        }
+    } initializer;
+}
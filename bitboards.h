@@ -0,0 +1,117 @@
+/* Chess --- bitboards.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_BITBOARDS_H
+#define CHESS_BITBOARDS_H
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define CHESS_USE_PEXT
+#endif
+
+using namespace std;
+
+// Every bit of a bitboard represents a square,
+// bit 0 is a1, bit 7 is h1 and bit 63 is h8
+using Bitboard = uint64_t;
+
+// Namespace that holds the precomputed attack tables
+namespace Bitboards {
+    const Bitboard FILE_A = 0x0101010101010101ULL;
+    const Bitboard FILE_H = FILE_A << 7;
+    const Bitboard RANK_1 = 0xFFULL;
+    const Bitboard RANK_8 = RANK_1 << 56;
+
+    // Lookup data of a sliding piece on one square
+    // Either a magic multiplication or a PEXT instruction
+    // turns the relevant occupancy into an index of attacks
+    struct Magic {
+        Bitboard mask;
+        Bitboard magic;
+        Bitboard* attacks;
+        int shift;
+
+        unsigned index(const Bitboard occupied) const {
+#ifdef CHESS_USE_PEXT
+            return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+            return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+        }
+    };
+
+    // The tables are filled once when the program starts
+    extern Bitboard knightTable[64];
+    extern Bitboard kingTable[64];
+    extern Bitboard pawnTable[2][64];
+    extern Magic rookMagics[64];
+    extern Magic bishopMagics[64];
+
+    // Squares strictly between two squares on a line, and
+    // the whole line through them, empty if not on a line
+    extern Bitboard betweenTable[64][64];
+    extern Bitboard lineTable[64][64];
+
+    inline Bitboard squareBit(const int square) {
+        return 1ULL << square;
+    }
+
+    // Returns the index of the least significant set bit
+    inline int lsb(const Bitboard bitboard) {
+        return countr_zero(bitboard);
+    }
+
+    // Returns the least significant square and removes it from the bitboard
+    inline int popLsb(Bitboard& bitboard) {
+        const int square = countr_zero(bitboard);
+        bitboard &= bitboard - 1;
+        return square;
+    }
+
+    inline int popCount(const Bitboard bitboard) {
+        return popcount(bitboard);
+    }
+
+    inline Bitboard knightAttacks(const int square) {
+        return knightTable[square];
+    }
+
+    inline Bitboard kingAttacks(const int square) {
+        return kingTable[square];
+    }
+
+    // Squares attacked by a pawn of the given color (0 white, 1 black)
+    inline Bitboard pawnAttacks(const int color, const int square) {
+        return pawnTable[color][square];
+    }
+
+    inline Bitboard rookAttacks(const int square, const Bitboard occupied) {
+        const Magic& magic = rookMagics[square];
+        return magic.attacks[magic.index(occupied)];
+    }
+
+    inline Bitboard bishopAttacks(const int square, const Bitboard occupied) {
+        const Magic& magic = bishopMagics[square];
+        return magic.attacks[magic.index(occupied)];
+    }
+
+    inline Bitboard queenAttacks(const int square, const Bitboard occupied) {
+        return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+    }
+
+    inline Bitboard between(const int a, const int b) {
+        return betweenTable[a][b];
+    }
+
+    inline Bitboard line(const int a, const int b) {
+        return lineTable[a][b];
+    }
+}
+
+
+#endif //CHESS_BITBOARDS_H
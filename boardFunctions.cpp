@@ -6,209 +6,328 @@
 #include "boardFunctions.h"
 #include <iostream>
 #include <algorithm>
+#include <random>
+#include <sstream>
+
+using namespace Bitboards;
+
+namespace Zobrist {
+    uint64_t pieceKeys[2][6][64];
+    uint64_t castlingKeys[16];
+    uint64_t enPassantKeys[8];
+    uint64_t sideKey;
+
+    namespace {
+        // Fills the keys with a fixed seed, so
+        // hashes are the same on every run
+        struct Initializer {
+            Initializer() {
+                mt19937_64 generator(20251118);
+                for (auto& colorKeys : pieceKeys) {
+                    for (auto& typeKeys : colorKeys) {
+                        for (uint64_t& key : typeKeys) key = generator();
+                    }
+                }
+                sideKey = generator();
+
+                // Rights are keyed as a set, so one XOR
+                // swaps the old set for the new one
+                for (uint64_t& key : castlingKeys) key = generator();
+                castlingKeys[0] = 0;
+                for (uint64_t& key : enPassantKeys) key = generator();
+            }
+        } initializer;
+    }
+}
 
 namespace HelperFunctions {
-    // Returns color of piece
-    Color getColor(const char piece) {
-        if (piece == '0') return EMPTY;
-        return islower(piece) ? WHITE : BLACK;
+    // Castling rights that stay after a piece moves from or to
+    // each square, moving the king or a rook loses them
+    const int castlingMasks[64] = {
+        13, 15, 15, 15, 12, 15, 15, 14,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+         7, 15, 15, 15,  3, 15, 15, 11,
+    };
+
+    // Returns the piece character of a color and piece type
+    char getPiece(const Color color, const PieceType type) {
+        const char piece = "pnbrqk"[type];
+        return color == WHITE ? piece : static_cast<char>(toupper(piece));
     }
 
-    // Checks if given index is in bounds
-    bool isInBounds(const int index) {
-        return index >= 0 && index < 64;
+    // Places a piece on an empty square
+    void putPiece(Board& board, const char piece, const int index) {
+        const Color color = BoardFunctions::getColor(piece);
+        const PieceType type = BoardFunctions::getPieceType(piece);
+        const Bitboard bit = squareBit(index);
+
+        board.pieces[color][type] |= bit;
+        board.colors[color] |= bit;
+        board.occupied |= bit;
+        board.squares[index] = piece;
+        board.key ^= Zobrist::pieceKeys[color][type][index];
+        if (type == PAWN) board.pawnKey ^= Zobrist::pieceKeys[color][PAWN][index];
+        board.evaluation += PieceSquareTables::values[color][type][index];
+        if (type == KING) board.kingSquares[color] = index;
     }
 
-    // Checks if given xy coordinates are in bounds
-    bool isInBounds(const int x, const int y) {
-        return x >= 0 && x < 8 && y >= 0 && y < 8;
+    // Removes the piece on a square
+    void removePiece(Board& board, const int index) {
+        const char piece = board.squares[index];
+        const Color color = BoardFunctions::getColor(piece);
+        const PieceType type = BoardFunctions::getPieceType(piece);
+        const Bitboard bit = squareBit(index);
+
+        board.pieces[color][type] &= ~bit;
+        board.colors[color] &= ~bit;
+        board.occupied &= ~bit;
+        board.squares[index] = '0';
+        board.key ^= Zobrist::pieceKeys[color][type][index];
+        if (type == PAWN) board.pawnKey ^= Zobrist::pieceKeys[color][PAWN][index];
+        board.evaluation -= PieceSquareTables::values[color][type][index];
+        if (type == KING) board.kingSquares[color] = NO_SQUARE;
     }
 
-    // Checks if a piece can move in the given direction
-    // Returns true if the pieces vision ends (either the edge
-    // of the board or another piece is there), false if the piece
-    // can see further.
-    // board is the gameboard, moves is the available moves the piece
-    // can make, flag governs whether to keep checking for squares
-    // piece_color is piece's color, and xy are the coordinates of the
-    // target square
-    bool canMove(const Board &board, Moves &moves, const bool flag,
-                        const Color piece_color, const int index, const int x, const int y) {
-        const int target_index = y * 8 + x;
-
-        if (!flag && isInBounds(x, y)) {
-            if (board[target_index] == '0') {
-                moves.emplace_back(index, target_index);
-                return false;
-            }
-            if (getColor(board[target_index]) != piece_color) {
-                moves.emplace_back(index, target_index);
-                return true;
-            }
-            return true;
-        }
-        return true;
+    // Removes all the pieces
+    void clearBoard(Board& board) {
+        board = Board{};
+        for (char& square : board.squares) square = '0';
+        board.kingSquares[WHITE] = board.kingSquares[BLACK] = NO_SQUARE;
+        board.enPassantSquare = NO_SQUARE;
     }
 
-    // Returns all available squares in the straight directions
-    // Used for rook and queen movement
-    void getStraightMoves(const Board &board, Moves &moves, const int index) {
-
-        bool upFlag = false;
-        bool downFlag = false;
-        bool leftFlag = false;
-        bool rightFlag = false;
-
-        const int x = index % 8;
-        const int y = index / 8;
+    // Moves a piece to an empty square
+    void movePiece(Board& board, const int start, const int end) {
+        const char piece = board[start];
+        removePiece(board, start);
+        putPiece(board, piece, end);
+    }
 
-        const Color piece_color = getColor(board[index]);
+    // Sets the castling rights, keeping the key up to date
+    void setCastlingRights(Board& board, const int rights) {
+        board.key ^= Zobrist::castlingKeys[board.castlingRights] ^ Zobrist::castlingKeys[rights];
+        board.castlingRights = rights;
+    }
 
-        for (int i = 1; i < 8; i++) {
-            upFlag = canMove(board, moves, upFlag, piece_color, index, x, y + i);
-            downFlag = canMove(board, moves, downFlag, piece_color, index, x, y - i);
-            leftFlag = canMove(board, moves, leftFlag, piece_color, index, x - i, y);
-            rightFlag = canMove(board, moves, rightFlag, piece_color, index, x + i, y);
+    // Sets the en passant square, keeping the key up to date
+    // The square is only kept if a pawn of the given color can
+    // capture there, so positions that only differ by a useless
+    // en passant square get the same key
+    void setEnPassantSquare(Board& board, const int square, const Color capturer) {
+        if (board.enPassantSquare != NO_SQUARE) board.key ^= Zobrist::enPassantKeys[board.enPassantSquare % 8];
+        board.enPassantSquare = NO_SQUARE;
+
+        if (square != NO_SQUARE && pawnAttacks(capturer == WHITE ? BLACK : WHITE, square) & board.pieces[capturer][PAWN]) {
+            board.enPassantSquare = square;
+            board.key ^= Zobrist::enPassantKeys[square % 8];
         }
     }
 
-    // Returns all available squares in the diagonal directions
-    // Used for bishop and queen movement
-    void getDiagonalMoves(const Board &board, Moves &moves, const int index) {
-
-        bool urFlag = false;
-        bool ulFlag = false;
-        bool drFlag = false;
-        bool dlFlag = false;
-
-        const int x = index % 8;
-        const int y = index / 8;
-
-        const Color piece_color = getColor(board[index]);
+    // Adds a move from index to every square of the targets
+    void addMoves(Moves& moves, const int index, Bitboard targets) {
+        while (targets) {
+            moves.push_back(Move(index, popLsb(targets)));
+        }
+    }
 
-        for (int i = 1; i < 8; i++) {
-            urFlag = canMove(board, moves, urFlag, piece_color, index, x + i, y + i);
-            ulFlag = canMove(board, moves, ulFlag, piece_color, index, x - i, y + i);
-            drFlag = canMove(board, moves, drFlag, piece_color, index, x + i, y - i);
-            dlFlag = canMove(board, moves, dlFlag, piece_color, index, x - i, y - i);
+    // Adds a pawn move, or all four promotions on the last rank
+    void addPawnMove(Moves& moves, const int index, const int target, const MoveFlag flag = NORMAL_MOVE) {
+        if (target / 8 == 0 || target / 8 == 7) {
+            moves.push_back(Move(index, target, PROMOTE_QUEEN));
+            moves.push_back(Move(index, target, PROMOTE_KNIGHT));
+            moves.push_back(Move(index, target, PROMOTE_ROOK));
+            moves.push_back(Move(index, target, PROMOTE_BISHOP));
+            return;
         }
+        moves.push_back(Move(index, target, flag));
     }
 
-    // Returns all available squares in the knight's directions
-    void getKnightMoves(const Board &board, Moves &moves, const int index) {
+    // What the moves of the side to move have to respect so
+    // that they don't leave their own king under attack
+    struct MoveMasks {
+        // Square of the king, NO_SQUARE if there is none
+        int king;
+
+        // Opponent pieces giving check
+        Bitboard checkers;
+
+        // Squares the other pieces may move to: the checker and the
+        // squares between it and the king when in check, none in
+        // double check, since only the king can move then, and all
+        // the squares otherwise
+        Bitboard targets;
+
+        // Pieces that would uncover an attack on their king
+        // if they left the line between the king and the attacker
+        Bitboard pinned;
+    };
+
+    template <Color Turn>
+    MoveMasks getMoveMasks(const Board& board) {
+        constexpr Color opponent = Turn == WHITE ? BLACK : WHITE;
+        MoveMasks masks = {board.kingSquares[Turn], 0, ~0ULL, 0};
+        if (masks.king == NO_SQUARE) return masks;
+
+        masks.checkers = BoardFunctions::getAttackers(board, masks.king, board.occupied) & board.colors[opponent];
+        if (popCount(masks.checkers) > 1) masks.targets = 0;
+        else if (masks.checkers) masks.targets = masks.checkers | between(masks.king, lsb(masks.checkers));
+
+        // Sliders that would attack the king if there was only one piece
+        // in the way, which is pinned when it is of the side to move
+        const Bitboard* pieces = board.pieces[opponent];
+        Bitboard snipers = (rookAttacks(masks.king, 0) & (pieces[ROOK] | pieces[QUEEN])) |
+                           (bishopAttacks(masks.king, 0) & (pieces[BISHOP] | pieces[QUEEN]));
+        while (snipers) {
+            const Bitboard blockers = between(masks.king, popLsb(snipers)) & board.occupied;
+            if (popCount(blockers) == 1) masks.pinned |= blockers & board.colors[Turn];
+        }
+        return masks;
+    }
 
-        const int x = index % 8;
-        const int y = index / 8;
+    // Squares the piece on index may move to without exposing its king
+    Bitboard allowedSquares(const MoveMasks& masks, const int index) {
+        if (masks.pinned & squareBit(index)) return masks.targets & line(masks.king, index);
+        return masks.targets;
+    }
 
-        const Color piece_color = getColor(board[index]);
+    // Returns if the king could stand on the square, the king is taken
+    // off the board first so it doesn't block an attack along its line
+    bool isSafeForKing(const Board& board, const int king, const int square, const Color opponent) {
+        return !(BoardFunctions::getAttackers(board, square, board.occupied ^ squareBit(king)) & board.colors[opponent]);
+    }
 
-        canMove(board, moves, false, piece_color, index, x + 1, y + 2);
-        canMove(board, moves, false, piece_color, index, x - 1, y + 2);
+    // En passant takes two pawns off the same rank at once, which can
+    // uncover an attack the pins don't see, so it is tested by making it
+    bool isLegalEnPassant(const Board& board, const Move move, const Color turn) {
+        Board copy = board;
+        BoardFunctions::makeMove(copy, move);
+        return !BoardFunctions::isInCheck(copy, turn);
+    }
 
-        canMove(board, moves, false, piece_color, index, x + 2, y + 1);
-        canMove(board, moves, false, piece_color, index, x - 2, y + 1);
+    // Returns all available squares in the straight directions
+    // Used for rook and queen movement
+    template <Color Turn>
+    void getStraightMoves(const Board &board, Moves &moves, const int index, const Bitboard allowed) {
+        addMoves(moves, index, rookAttacks(index, board.occupied) & ~board.colors[Turn] & allowed);
+    }
 
-        canMove(board, moves, false, piece_color, index, x + 2, y - 1);
-        canMove(board, moves, false, piece_color, index, x - 2, y - 1);
+    // Returns all available squares in the diagonal directions
+    // Used for bishop and queen movement
+    template <Color Turn>
+    void getDiagonalMoves(const Board &board, Moves &moves, const int index, const Bitboard allowed) {
+        addMoves(moves, index, bishopAttacks(index, board.occupied) & ~board.colors[Turn] & allowed);
+    }
 
-        canMove(board, moves, false, piece_color, index, x + 1, y - 2);
-        canMove(board, moves, false, piece_color, index, x - 1, y - 2);
+    // Returns all available squares in the knight's directions
+    template <Color Turn>
+    void getKnightMoves(const Board &board, Moves &moves, const int index, const Bitboard allowed) {
+        addMoves(moves, index, knightAttacks(index) & ~board.colors[Turn] & allowed);
     }
 
     // Returns all available moves a pawn can make
-    void getPawnMoves(const Board &board, Moves &moves, const int index) {
-        const int x = index % 8;
-        const int y = index / 8;
-
-        const Color piece_color = getColor(board[index]);
-        const Color opponent_color = piece_color == WHITE ? BLACK : WHITE;
-
-        const int direction = piece_color == WHITE ? 1 : -1;
-
-        // Check pawn movement without canMove as pawn is special
-        // in the sense that if it can move it cannot capture
-        // but if it can capture it cannot move to that square
-        if (isInBounds(x, y + direction) && board[index + 8 * direction] == '0') {
-            moves.emplace_back(index, index + 8 * direction);
-        }
-
-        if ((piece_color == WHITE && y == 1) || (piece_color == BLACK && y == 6)) {
-            if (isInBounds(index + 16 * direction) && board[index + 8 * direction] == '0' && board[index + 16 * direction] == '0') {
-                moves.emplace_back(index, index + 16 * direction);
+    template <Color Turn>
+    void getPawnMoves(const Board &board, Moves &moves, const int index, const Bitboard allowed) {
+        constexpr Color opponent = Turn == WHITE ? BLACK : WHITE;
+        constexpr int direction = Turn == WHITE ? 8 : -8;
+        constexpr int startRank = Turn == WHITE ? 1 : 6;
+
+        // Pawn is special in the sense that if it can move it cannot
+        // capture but if it can capture it cannot move to that square
+        // A pawn never stands on the last rank, so the square
+        // in front of it is always on the board
+        if (board[index + direction] == '0') {
+            if (allowed & squareBit(index + direction)) addPawnMove(moves, index, index + direction);
+
+            if (index / 8 == startRank && board[index + 2 * direction] == '0' &&
+                allowed & squareBit(index + 2 * direction)) {
+                moves.push_back(Move(index, index + 2 * direction));
             }
         }
 
-        if (isInBounds(x + 1, y + direction) && getColor(board[index + 1 + 8 * direction]) == opponent_color) {
-            moves.emplace_back(index, index + 1 + 8 * direction);
+        Bitboard captures = pawnAttacks(Turn, index) & board.colors[opponent] & allowed;
+        while (captures) {
+            addPawnMove(moves, index, popLsb(captures));
         }
 
-        if (isInBounds(x - 1, y + direction) && getColor(board[index - 1 + 8 * direction]) == opponent_color) {
-            moves.emplace_back(index, index - 1 + 8 * direction);
+        // The square behind a pawn that just moved two squares
+        // can be captured as if it had moved one
+        if (board.enPassantSquare != NO_SQUARE && pawnAttacks(Turn, index) & squareBit(board.enPassantSquare)) {
+            const Move move(index, board.enPassantSquare, EN_PASSANT);
+            if (isLegalEnPassant(board, move, Turn)) moves.push_back(move);
         }
     }
 
     // Returns all available moves for the king
+    template <Color Turn>
     void getKingMoves(const Board &board, Moves &moves, const int index) {
-        const int x = index % 8;
-        const int y = index / 8;
-
-        const Color piece_color = getColor(board[index]);
+        constexpr Color opponent = Turn == WHITE ? BLACK : WHITE;
+        Bitboard targets = kingAttacks(index) & ~board.colors[Turn];
+        while (targets) {
+            const int target = popLsb(targets);
+            if (isSafeForKing(board, index, target, opponent)) moves.push_back(Move(index, target));
+        }
 
-        for (int i = 0; i < 9; i++) {
-            // King's own square
-            // canMove function will fail even if this
-            // check isn't inplace, but saves computation
-            if (i == 4) continue;
+        // Castling needs the squares between the king and the rook to
+        // be empty, and the king can't castle out of, through or into check
+        constexpr int kingside = Turn == WHITE ? WHITE_KINGSIDE : BLACK_KINGSIDE;
+        constexpr int queenside = Turn == WHITE ? WHITE_QUEENSIDE : BLACK_QUEENSIDE;
+        const int rights = board.castlingRights & (kingside | queenside);
+        if (!rights) return;
+        if (BoardFunctions::isSquareAttacked(board, index, opponent)) return;
+
+        if (rights & kingside &&
+            !(board.occupied & (squareBit(index + 1) | squareBit(index + 2))) &&
+            !BoardFunctions::isSquareAttacked(board, index + 1, opponent) &&
+            !BoardFunctions::isSquareAttacked(board, index + 2, opponent)) {
+            moves.push_back(Move(index, index + 2, CASTLING));
+        }
 
-            const int x_offset = i % 3 - 1;
-            const int y_offset = i / 3 - 1;
-            canMove(board, moves, false, piece_color, index, x + x_offset, y + y_offset);
+        if (rights & queenside &&
+            !(board.occupied & (squareBit(index - 1) | squareBit(index - 2) | squareBit(index - 3))) &&
+            !BoardFunctions::isSquareAttacked(board, index - 1, opponent) &&
+            !BoardFunctions::isSquareAttacked(board, index - 2, opponent)) {
+            moves.push_back(Move(index, index - 2, CASTLING));
         }
     }
 
 
-    // Returns the available moves for a given piece
+    // Returns the legal moves for a given piece
     // board is gameboard, moves is move vector to modify,
-    // index is piece's square
-    void getAvailableMoves(const Board& board, Moves& moves, const int index) {
-        switch (tolower(board[index])) {
-            case 'r':
-                getStraightMoves(board, moves, index);
+    // index is piece's square, masks are the check and
+    // pin masks of the piece's color
+    template <Color Turn>
+    void getAvailableMoves(const Board& board, Moves& moves, const int index, const MoveMasks& masks) {
+        const Bitboard allowed = allowedSquares(masks, index);
+        switch (BoardFunctions::getPieceType(board[index])) {
+            case ROOK:
+                getStraightMoves<Turn>(board, moves, index, allowed);
                 break;
-            case 'n':
-                getKnightMoves(board, moves, index);
+            case KNIGHT:
+                getKnightMoves<Turn>(board, moves, index, allowed);
                 break;
-            case 'b':
-                getDiagonalMoves(board, moves, index);
+            case BISHOP:
+                getDiagonalMoves<Turn>(board, moves, index, allowed);
                 break;
-            case 'q':
-                getStraightMoves(board, moves, index);
-                getDiagonalMoves(board, moves, index);
+            case QUEEN:
+                getStraightMoves<Turn>(board, moves, index, allowed);
+                getDiagonalMoves<Turn>(board, moves, index, allowed);
                 break;
-            case 'k':
-                getKingMoves(board, moves, index);
+            case KING:
+                getKingMoves<Turn>(board, moves, index);
                 break;
-            case 'p':
-                getPawnMoves(board, moves, index);
+            case PAWN:
+                getPawnMoves<Turn>(board, moves, index, allowed);
                 break;
             default:
                 break;
         }
     }
 
-    // Attempts a promotion
-    // Function is called from makeMove which has
-    // the pawn check already
-    void attemptPromotion(Board& board, const int start, const int end) {
-        const int y = end / 8;
-
-        const Color piece_color = getColor(board[start]);
-
-        if ((piece_color == WHITE && y == 7) || (piece_color == BLACK && y == 0)) {
-            board[start] = piece_color == WHITE ? 'q' : 'Q';
-        }
-    }
-
 }
 
 using namespace HelperFunctions;
@@ -229,105 +348,449 @@ namespace BoardFunctions {
         cout << endl << endl;
     }
 
-    Color isGameOver(const Board& board) {
-        // White king captured -> black win
-        const auto foundWhiteKing =
-            find(board.begin(),
-            board.end(),
-            'k');
-        if (foundWhiteKing == board.end()) return BLACK;
-
-        // Black king captured -> white win
-        const auto foundBlackKing =
-            find(board.begin(),
-            board.end(),
-            'K');
-        if (foundBlackKing == board.end()) return WHITE;
-
-        // Game still ongoing
-        return EMPTY;
+    GameState getGameState(const Board& board, const Color turn) {
+        Moves moves;
+        getAllAvailableMoves(board, moves, turn);
+        if (!moves.empty()) return ONGOING;
+        return isInCheck(board, turn) ? CHECKMATE : STALEMATE;
     }
 
 
-    bool isLegalMove(const Board& board, const int start, const int end, const Color turn) {
+    bool isLegalMove(const Board& board, const Move move, const Color turn) {
         // It's not the player's color
-        if (getColor(board[start]) != turn) return false;
+        if (getColor(board[move.start()]) != turn) return false;
 
-        // Check if the piece can move to the target square
-        // All the necessary checks are handled in canMove
-        // inside the getAvailableMoves
+        // Check if the piece can make the move
         Moves availableMoves;
-        getAvailableMoves(board, availableMoves, start);
-        const auto foundMove =
-            find(availableMoves.begin(),
-            availableMoves.end(),
-            pair(start, end));
-        return foundMove != availableMoves.end();
+        if (turn == WHITE) getAvailableMoves<WHITE>(board, availableMoves, move.start(), getMoveMasks<WHITE>(board));
+        else getAvailableMoves<BLACK>(board, availableMoves, move.start(), getMoveMasks<BLACK>(board));
+        return find(availableMoves.begin(), availableMoves.end(), move) != availableMoves.end();
+    }
+
+    Move createMove(const Board& board, const int start, const int end, const PieceType promotion) {
+        // Invalid notation was given
+        if (start < 0 || end < 0) return NO_MOVE;
+
+        const PieceType type = getPieceType(board[start]);
+        if (type == PAWN && (end / 8 == 0 || end / 8 == 7)) {
+            return Move(start, end, static_cast<MoveFlag>(promotion + 3));
+        }
+        if (type == PAWN && end == board.enPassantSquare) return Move(start, end, EN_PASSANT);
+        if (type == KING && abs(end - start) == 2) return Move(start, end, CASTLING);
+        return Move(start, end);
+    }
+
+    UndoInfo makeMove(Board &board, const Move move) {
+        const int start = move.start();
+        const int end = move.end();
+        const char piece = board[start];
+        const Color color = getColor(piece);
+        const int direction = color == WHITE ? 8 : -8;
+
+        const UndoInfo undo = {
+            move.flag() == EN_PASSANT ? board[end - direction] : board[end],
+            board.castlingRights,
+            board.enPassantSquare,
+            board.key
+        };
+
+        // The pawn captured en passant is behind the target square
+        if (move.flag() == EN_PASSANT) removePiece(board, end - direction);
+        else if (board[end] != '0') removePiece(board, end);
+
+        removePiece(board, start);
+        putPiece(board, move.isPromotion() ? getPiece(color, move.promotion()) : piece, end);
+
+        // The rook jumps over the king
+        if (move.flag() == CASTLING) {
+            if (end > start) movePiece(board, start + 3, start + 1);
+            else movePiece(board, start - 4, start - 1);
+        }
+
+        const bool doublePush = getPieceType(piece) == PAWN && abs(end - start) == 16;
+        setEnPassantSquare(board, doublePush ? start + direction : NO_SQUARE, color == WHITE ? BLACK : WHITE);
+        setCastlingRights(board, board.castlingRights & castlingMasks[start] & castlingMasks[end]);
+        return undo;
+    }
+
+    void unmakeMove(Board &board, const Move move, const UndoInfo& undo) {
+        const int start = move.start();
+        const int end = move.end();
+        const Color color = getColor(board[end]);
+
+        movePiece(board, end, start);
+        if (move.isPromotion()) {
+            removePiece(board, start);
+            putPiece(board, getPiece(color, PAWN), start);
+        }
+
+        if (move.flag() == CASTLING) {
+            if (end > start) movePiece(board, start + 1, start + 3);
+            else movePiece(board, start - 1, start - 4);
+        }
+
+        if (undo.captured != '0') {
+            putPiece(board, undo.captured, move.flag() == EN_PASSANT ? end - (color == WHITE ? 8 : -8) : end);
+        }
+
+        board.castlingRights = undo.castlingRights;
+        board.enPassantSquare = undo.enPassantSquare;
+        board.key = undo.key;
+    }
+
+    UndoInfo makeNullMove(Board& board) {
+        const UndoInfo undo = {'0', board.castlingRights, board.enPassantSquare, board.key};
+        setEnPassantSquare(board, NO_SQUARE, WHITE);
+        return undo;
+    }
+
+    void unmakeNullMove(Board& board, const UndoInfo& undo) {
+        board.enPassantSquare = undo.enPassantSquare;
+        board.key = undo.key;
+    }
+
+    template <Color Turn>
+    void getAllAvailableMoves(const Board& board, Moves& moves) {
+        const MoveMasks masks = getMoveMasks<Turn>(board);
+        const Bitboard* pieces = board.pieces[Turn];
+
+        // In double check only the king can move
+        if (masks.targets) {
+            Bitboard pawns = pieces[PAWN];
+            while (pawns) {
+                const int index = popLsb(pawns);
+                getPawnMoves<Turn>(board, moves, index, allowedSquares(masks, index));
+            }
+
+            // A pinned knight can never stay on the line of its pin
+            Bitboard knights = pieces[KNIGHT] & ~masks.pinned;
+            while (knights) getKnightMoves<Turn>(board, moves, popLsb(knights), masks.targets);
+
+            Bitboard diagonals = pieces[BISHOP] | pieces[QUEEN];
+            while (diagonals) {
+                const int index = popLsb(diagonals);
+                getDiagonalMoves<Turn>(board, moves, index, allowedSquares(masks, index));
+            }
+
+            Bitboard straights = pieces[ROOK] | pieces[QUEEN];
+            while (straights) {
+                const int index = popLsb(straights);
+                getStraightMoves<Turn>(board, moves, index, allowedSquares(masks, index));
+            }
+        }
+        if (masks.king != NO_SQUARE) getKingMoves<Turn>(board, moves, masks.king);
     }
 
-    void makeMove(Board &board, const int start, const int end) {
-        if (tolower(board[start]) == 'p') attemptPromotion(board, start, end);
-        board[end] = board[start];
-        board[start] = '0';
+    template <Color Turn>
+    void getAllAvailableCaptures(const Board& board, Moves& moves) {
+        constexpr Color opponent = Turn == WHITE ? BLACK : WHITE;
+        constexpr Bitboard lastRank = Turn == WHITE ? RANK_8 : RANK_1;
+        constexpr int direction = Turn == WHITE ? 8 : -8;
+        const Bitboard targets = board.colors[opponent];
+        const MoveMasks masks = getMoveMasks<Turn>(board);
+        const Bitboard* pieces = board.pieces[Turn];
+
+        if (masks.targets) {
+            Bitboard pawns = pieces[PAWN];
+            while (pawns) {
+                const int index = popLsb(pawns);
+                const Bitboard allowed = allowedSquares(masks, index);
+
+                // Captures promote to every piece, but
+                // a quiet push only promotes to a queen
+                Bitboard captures = pawnAttacks(Turn, index) & targets & allowed;
+                while (captures) addPawnMove(moves, index, popLsb(captures));
+
+                const int push = index + direction;
+                if (squareBit(push) & lastRank & allowed && board[push] == '0') {
+                    moves.push_back(Move(index, push, PROMOTE_QUEEN));
+                }
+                if (board.enPassantSquare != NO_SQUARE &&
+                    pawnAttacks(Turn, index) & squareBit(board.enPassantSquare)) {
+                    const Move move(index, board.enPassantSquare, EN_PASSANT);
+                    if (isLegalEnPassant(board, move, Turn)) moves.push_back(move);
+                }
+            }
+
+            Bitboard knights = pieces[KNIGHT] & ~masks.pinned;
+            while (knights) {
+                const int index = popLsb(knights);
+                addMoves(moves, index, knightAttacks(index) & targets & masks.targets);
+            }
+
+            Bitboard diagonals = pieces[BISHOP] | pieces[QUEEN];
+            while (diagonals) {
+                const int index = popLsb(diagonals);
+                addMoves(moves, index, bishopAttacks(index, board.occupied) & targets & allowedSquares(masks, index));
+            }
+
+            Bitboard straights = pieces[ROOK] | pieces[QUEEN];
+            while (straights) {
+                const int index = popLsb(straights);
+                addMoves(moves, index, rookAttacks(index, board.occupied) & targets & allowedSquares(masks, index));
+            }
+        }
+
+        if (masks.king != NO_SQUARE) {
+            Bitboard captures = kingAttacks(masks.king) & targets;
+            while (captures) {
+                const int target = popLsb(captures);
+                if (isSafeForKing(board, masks.king, target, opponent)) moves.push_back(Move(masks.king, target));
+            }
+        }
     }
 
+    template void getAllAvailableMoves<WHITE>(const Board& board, Moves& moves);
+    template void getAllAvailableMoves<BLACK>(const Board& board, Moves& moves);
+    template void getAllAvailableCaptures<WHITE>(const Board& board, Moves& moves);
+    template void getAllAvailableCaptures<BLACK>(const Board& board, Moves& moves);
+
     void getAllAvailableMoves(const Board& board, Moves& moves, const Color turn) {
-        for (int i = 0; i < 64; i++) {
-            const char piece = board[i];
-            if (piece == '0') continue;
+        if (turn == WHITE) getAllAvailableMoves<WHITE>(board, moves);
+        else getAllAvailableMoves<BLACK>(board, moves);
+    }
+
+    void getAllAvailableCaptures(const Board& board, Moves& moves, const Color turn) {
+        if (turn == WHITE) getAllAvailableCaptures<WHITE>(board, moves);
+        else getAllAvailableCaptures<BLACK>(board, moves);
+    }
 
-            if (turn == getColor(piece)) getAvailableMoves(board, moves, i);
+    Bitboard getAttackers(const Board& board, const int square, const Bitboard occupied) {
+        const Bitboard bishops = board.pieces[WHITE][BISHOP] | board.pieces[BLACK][BISHOP] |
+                                 board.pieces[WHITE][QUEEN] | board.pieces[BLACK][QUEEN];
+        const Bitboard rooks = board.pieces[WHITE][ROOK] | board.pieces[BLACK][ROOK] |
+                               board.pieces[WHITE][QUEEN] | board.pieces[BLACK][QUEEN];
+
+        return (pawnAttacks(BLACK, square) & board.pieces[WHITE][PAWN]) |
+               (pawnAttacks(WHITE, square) & board.pieces[BLACK][PAWN]) |
+               (knightAttacks(square) & (board.pieces[WHITE][KNIGHT] | board.pieces[BLACK][KNIGHT])) |
+               (kingAttacks(square) & (board.pieces[WHITE][KING] | board.pieces[BLACK][KING])) |
+               (bishopAttacks(square, occupied) & bishops) |
+               (rookAttacks(square, occupied) & rooks);
+    }
+
+    int staticExchange(const Board& board, const Move move) {
+        // The king is worth more than everything else,
+        // so capturing with it into an attack always loses
+        const int exchangeValues[6] = {10, 30, 30, 50, 90, 1000};
+        if (move.flag() == CASTLING) return 0;
+
+        const int target = move.end();
+        Bitboard occupied = board.occupied ^ squareBit(move.start());
+        Color side = getColor(board[move.start()]);
+
+        // gains[i] is what the side making the ith capture
+        // wins, if the exchange stopped right after it
+        int gains[32];
+        int depth = 0;
+        PieceType onTarget = getPieceType(board[move.start()]);
+        if (move.flag() == EN_PASSANT) {
+            gains[0] = exchangeValues[PAWN];
+            occupied ^= squareBit(target + (side == WHITE ? -8 : 8));
+        }
+        else {
+            const PieceType captured = getPieceType(board[target]);
+            gains[0] = captured == NO_PIECE ? 0 : exchangeValues[captured];
+        }
+        if (move.isPromotion()) {
+            gains[0] += exchangeValues[move.promotion()] - exchangeValues[PAWN];
+            onTarget = move.promotion();
+        }
+
+        // Sliders behind a capturing piece join in once it is gone,
+        // so the attackers are looked up again after every capture
+        Bitboard attackers = getAttackers(board, target, occupied) & occupied;
+        while (true) {
+            side = side == WHITE ? BLACK : WHITE;
+            const Bitboard sideAttackers = attackers & board.colors[side];
+            if (!sideAttackers) break;
+
+            int type = PAWN;
+            while (!(sideAttackers & board.pieces[side][type])) type++;
+
+            depth++;
+            gains[depth] = exchangeValues[onTarget] - gains[depth - 1];
+
+            onTarget = static_cast<PieceType>(type);
+            occupied ^= squareBit(lsb(sideAttackers & board.pieces[side][type]));
+            attackers = getAttackers(board, target, occupied) & occupied;
         }
+
+        // Each side only keeps capturing if that is better than stopping
+        while (depth > 0) {
+            depth--;
+            gains[depth] = -max(-gains[depth], gains[depth + 1]);
+        }
+        return gains[0];
+    }
+
+    uint64_t getHashKey(const Board& board, const Color turn) {
+        return turn == WHITE ? board.key : board.key ^ Zobrist::sideKey;
+    }
+
+    void clearBoard(Board& board) {
+        HelperFunctions::clearBoard(board);
+    }
+
+    void putPiece(Board& board, const char piece, const int index) {
+        HelperFunctions::putPiece(board, piece, index);
+    }
+
+    bool isSquareAttacked(const Board& board, const int square, const Color attacker) {
+        const Bitboard* pieces = board.pieces[attacker];
+        const Color defender = attacker == WHITE ? BLACK : WHITE;
+
+        // A piece on the square would attack the
+        // attackers with the same kind of move
+        return (pawnAttacks(defender, square) & pieces[PAWN]) ||
+               (knightAttacks(square) & pieces[KNIGHT]) ||
+               (kingAttacks(square) & pieces[KING]) ||
+               (bishopAttacks(square, board.occupied) & (pieces[BISHOP] | pieces[QUEEN])) ||
+               (rookAttacks(square, board.occupied) & (pieces[ROOK] | pieces[QUEEN]));
     }
 
+    bool isInCheck(const Board& board, const Color color) {
+        const int king = board.kingSquares[color];
+        return king != NO_SQUARE && isSquareAttacked(board, king, color == WHITE ? BLACK : WHITE);
+    }
 
     void populateBoard(Board &board) {
+        clearBoard(board);
+
         for (int i = 0; i < 64; i++) {
+            char piece = '0';
+
             // White pieces
             if (i == 0 || i == 7) {
-                board.emplace_back('r');
+                piece = 'r';
             }
             else if (i == 1 || i == 6) {
-                board.emplace_back('n');
+                piece = 'n';
             }
             else if (i == 2 || i == 5) {
-                board.emplace_back('b');
+                piece = 'b';
             }
             else if (i == 3) {
-                board.emplace_back('q');
+                piece = 'q';
             }
             else if (i == 4) {
-                board.emplace_back('k');
+                piece = 'k';
             }
             else if (i >= 8 && i <= 15) {
-                board.emplace_back('p');
+                piece = 'p';
             }
 
             // Black pieces
             else if (i >= 48 && i <= 55) {
-                board.emplace_back('P');
+                piece = 'P';
             }
             else if (i == 56 || i == 63) {
-                board.emplace_back('R');
+                piece = 'R';
             }
             else if (i == 57 || i == 62) {
-                board.emplace_back('N');
+                piece = 'N';
             }
             else if (i == 58 || i == 61) {
-                board.emplace_back('B');
+                piece = 'B';
             }
             else if (i == 59) {
-                board.emplace_back('Q');
+                piece = 'Q';
             }
             else if (i == 60) {
-                board.emplace_back('K');
+                piece = 'K';
             }
 
-            // Empty squares
+            // Empty squares stay as '0'
+            if (piece != '0') putPiece(board, piece, i);
+        }
+
+        setCastlingRights(board, WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    }
+
+    bool loadFen(Board& board, const string& fen, Color& turn) {
+        istringstream stream(fen);
+        string placement;
+        string side;
+        string castling = "-";
+        string enPassant = "-";
+        if (!(stream >> placement >> side)) return false;
+        if (side != "w" && side != "b") return false;
+        stream >> castling >> enPassant;
+
+        clearBoard(board);
+
+        // Ranks are listed from the 8th to the 1st
+        int rank = 7;
+        int file = 0;
+        for (const char c : placement) {
+            if (c == '/') {
+                if (file != 8 || rank == 0) return false;
+                rank--;
+                file = 0;
+            }
+            else if (c >= '1' && c <= '8') {
+                file += c - '0';
+                if (file > 8) return false;
+            }
             else {
-                board.emplace_back('0');
+                // FEN writes white pieces in uppercase, the board in lowercase
+                if (getPieceType(c) == NO_PIECE || file > 7) return false;
+                putPiece(board, static_cast<char>(isupper(c) ? tolower(c) : toupper(c)), rank * 8 + file);
+                file++;
             }
         }
+        if (rank != 0 || file != 8) return false;
+
+        turn = side == "w" ? WHITE : BLACK;
+
+        // Positions that can't come up in a game are turned down, the
+        // move generation relies on them: a king for each side, no pawns
+        // on the first or last rank and no check on the side that moved
+        const Bitboard pawns = board.pieces[WHITE][PAWN] | board.pieces[BLACK][PAWN];
+        if (pawns & (RANK_1 | RANK_8)) return false;
+        if (popCount(board.pieces[WHITE][KING]) != 1 ||
+            popCount(board.pieces[BLACK][KING]) != 1) return false;
+        if (isInCheck(board, turn == WHITE ? BLACK : WHITE)) return false;
+
+        // Rights without the king and rook on their squares are dropped
+        int rights = 0;
+        for (const char c : castling) {
+            if (c == 'K' && board[4] == 'k' && board[7] == 'r') rights |= WHITE_KINGSIDE;
+            if (c == 'Q' && board[4] == 'k' && board[0] == 'r') rights |= WHITE_QUEENSIDE;
+            if (c == 'k' && board[60] == 'K' && board[63] == 'R') rights |= BLACK_KINGSIDE;
+            if (c == 'q' && board[60] == 'K' && board[56] == 'R') rights |= BLACK_QUEENSIDE;
+        }
+        setCastlingRights(board, rights);
+
+        if (enPassant != "-") {
+            // The square is behind a pawn the other side has just moved two
+            // squares, so the square and the one the pawn came from are empty
+            const int square = convertNotationToIndex(enPassant);
+            if (square < 0 || square / 8 != (turn == WHITE ? 5 : 2)) return false;
+            const int forward = turn == WHITE ? -8 : 8;
+            const Color mover = turn == WHITE ? BLACK : WHITE;
+            if (getColor(board[square + forward]) != mover || getPieceType(board[square + forward]) != PAWN ||
+                board[square] != '0' || board[square - forward] != '0') return false;
+            setEnPassantSquare(board, square, turn);
+        }
+        return true;
+    }
+
+    Color getColor(const char piece) {
+        if (piece == '0') return EMPTY;
+        return islower(piece) ? WHITE : BLACK;
+    }
+
+    PieceType getPieceType(const char piece) {
+        switch (tolower(piece)) {
+            case 'p': return PAWN;
+            case 'n': return KNIGHT;
+            case 'b': return BISHOP;
+            case 'r': return ROOK;
+            case 'q': return QUEEN;
+            case 'k': return KING;
+            default: return NO_PIECE;
+        }
     }
 
     string convertIndexToNotation(const int index) {
@@ -337,7 +800,78 @@ namespace BoardFunctions {
         return {rank, row};
     }
 
+    string convertMoveToNotation(const Move move) {
+        string notation = convertIndexToNotation(move.start()) + convertIndexToNotation(move.end());
+        if (move.isPromotion()) notation += "pnbrqk"[move.promotion()];
+        return notation;
+    }
+
+    Move convertNotationToMove(const Board& board, const string& notation, const Color turn) {
+        if (notation.size() != 4 && notation.size() != 5) return NO_MOVE;
+
+        PieceType promotion = QUEEN;
+        if (notation.size() == 5) {
+            promotion = getPieceType(notation[4]);
+            if (promotion == PAWN || promotion == KING || promotion == NO_PIECE) return NO_MOVE;
+        }
+
+        const Move move = createMove(board, convertNotationToIndex(notation.substr(0, 2)),
+                                     convertNotationToIndex(notation.substr(2, 2)), promotion);
+        return move != NO_MOVE && isLegalMove(board, move, turn) ? move : NO_MOVE;
+    }
+
+    string convertLineToNotation(const vector<Move>& line) {
+        string notation;
+        for (const Move move : line) notation += (notation.empty() ? "" : " ") + convertMoveToNotation(move);
+        return notation;
+    }
+
+    string convertMoveToSan(const Board& board, const Move move, const Color turn) {
+        const int start = move.start();
+        const int end = move.end();
+        const PieceType type = getPieceType(board[start]);
+        const bool capture = board[end] != '0' || move.flag() == EN_PASSANT;
+        string san;
+
+        if (move.flag() == CASTLING) {
+            san = end > start ? "O-O" : "O-O-O";
+        }
+        else {
+            if (type == PAWN) {
+                if (capture) san += static_cast<char>('a' + start % 8);
+            }
+            else {
+                san += "PNBRQK"[type];
+
+                // Another piece of the same type reaching the square is told
+                // apart by the file if it can be, otherwise by the rank
+                Moves moves;
+                getAllAvailableMoves(board, moves, turn);
+                bool ambiguous = false, sameFile = false, sameRank = false;
+                for (const Move other : moves) {
+                    if (other.end() != end || other.start() == start || getPieceType(board[other.start()]) != type) continue;
+                    ambiguous = true;
+                    if (other.start() % 8 == start % 8) sameFile = true;
+                    if (other.start() / 8 == start / 8) sameRank = true;
+                }
+                if (ambiguous && !sameFile) san += static_cast<char>('a' + start % 8);
+                else if (ambiguous && !sameRank) san += static_cast<char>('1' + start / 8);
+                else if (ambiguous) san += convertIndexToNotation(start);
+            }
+            if (capture) san += 'x';
+            san += convertIndexToNotation(end);
+            if (move.isPromotion()) san += string("=") + "PNBRQK"[move.promotion()];
+        }
+
+        Board copy = board;
+        makeMove(copy, move);
+        const Color opponent = turn == WHITE ? BLACK : WHITE;
+        if (isInCheck(copy, opponent)) san += getGameState(copy, opponent) == CHECKMATE ? '#' : '+';
+        return san;
+    }
+
     int convertNotationToIndex(const string& notation) {
+        if (notation.size() != 2) return -1;
         if (notation[0] < 'a' || notation[0] > 'h') return -1;
         if (notation[1] < '1' || notation[1] > '8') return -1;
 
@@ -346,4 +880,4 @@ namespace BoardFunctions {
         int row = notation[1] - '1';
         return row * 8 + rank;
     }
-}
\ No newline at end of file
+}
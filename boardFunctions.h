@@ -6,17 +6,216 @@
 #ifndef CHESS_BOARDFUNCTIONS_H
 #define CHESS_BOARDFUNCTIONS_H
 
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <string>
+#include <vector>
+#include "bitboards.h"
 
 using namespace std;
-using Board = vector<char>;
-using Move = pair<int, int>;
-using Moves = vector<Move>;
 
 enum Color {WHITE, BLACK, EMPTY};
+enum PieceType {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, NO_PIECE};
+
+// Whether the side to move can still move, and why not
+enum GameState {ONGOING, CHECKMATE, STALEMATE};
+
+// Kinds of moves that need more than moving a piece
+// A promotion flag also tells the promoted piece
+enum MoveFlag {
+    NORMAL_MOVE = 0, EN_PASSANT = 1, CASTLING = 2,
+    PROMOTE_KNIGHT = 4, PROMOTE_BISHOP = 5, PROMOTE_ROOK = 6, PROMOTE_QUEEN = 7
+};
+
+// Castling rights, one bit for each side of both colors
+enum CastlingRight {
+    WHITE_KINGSIDE = 1, WHITE_QUEENSIDE = 2, BLACK_KINGSIDE = 4, BLACK_QUEENSIDE = 8
+};
+
+// Square of a missing king, or no en passant square
+const int NO_SQUARE = 64;
+
+// The most moves a position can have is 218
+const int MAX_MOVES = 256;
+
+// A move packed into 16 bits
+// start square : 6 bits | end square : 6 bits | flag : 4 bits
+class Move {
+public:
+    constexpr Move() : data_(0) {}
+    constexpr Move(const int start, const int end, const MoveFlag flag = NORMAL_MOVE)
+        : data_(static_cast<uint16_t>(start | end << 6 | flag << 12)) {}
+
+    // Rebuilds a move from its packed form
+    static constexpr Move fromData(const uint16_t data) {
+        Move move;
+        move.data_ = data;
+        return move;
+    }
+
+    constexpr int start() const { return data_ & 63; }
+    constexpr int end() const { return data_ >> 6 & 63; }
+    constexpr MoveFlag flag() const { return static_cast<MoveFlag>(data_ >> 12); }
+    constexpr uint16_t data() const { return data_; }
+
+    constexpr bool isPromotion() const { return data_ >> 14; }
+
+    // The piece a pawn is promoted to, only valid for promotions
+    constexpr PieceType promotion() const { return static_cast<PieceType>((data_ >> 12) - 3); }
+
+    constexpr bool operator==(const Move& other) const = default;
+private:
+    uint16_t data_;
+};
+
+// An empty move, a1 to a1 is never a real move
+const Move NO_MOVE;
+
+// Fixed capacity list of moves, so that
+// generating moves doesn't allocate
+class Moves {
+public:
+    void push_back(const Move move) { moves_[size_++] = move; }
+    void clear() { size_ = 0; }
+
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    Move& operator[](const int index) { return moves_[index]; }
+    const Move& operator[](const int index) const { return moves_[index]; }
+
+    Move* begin() { return moves_; }
+    Move* end() { return moves_ + size_; }
+    const Move* begin() const { return moves_; }
+    const Move* end() const { return moves_ + size_; }
+private:
+    Move moves_[MAX_MOVES];
+    int size_ = 0;
+};
+
+// What a move changed on the board, so that it can be taken back
+struct UndoInfo {
+    // The captured piece, '0' if nothing was captured
+    char captured;
+
+    // Castling rights and en passant square before the move
+    int castlingRights;
+    int enPassantSquare;
+
+    // Hash key before the move
+    uint64_t key;
+};
+
+// The game board, kept as bitboards for move generation
+// and as a square list for looking up single squares
+struct Board {
+    // Bitboards of every piece type for both colors
+    Bitboard pieces[2][6];
+
+    // Bitboards of all the pieces of a color
+    Bitboard colors[2];
+
+    // Bitboard of all the pieces on the board
+    Bitboard occupied;
+
+    // The piece on each square, in the character
+    // notation described in populateBoard
+    char squares[64];
+
+    // Zobrist hash of the pieces, updated with every change
+    uint64_t key;
+
+    // Zobrist hash of the pawns alone, the key of the pawn structure
+    uint64_t pawnKey;
+
+    // Material and square values of all the pieces, white pieces
+    // are added and black pieces subtracted, updated with every change
+    int evaluation;
+
+    // Squares of the kings, NO_SQUARE when missing
+    int kingSquares[2];
+
+    // Castling rights that are left, as CastlingRight bits
+    int castlingRights;
+
+    // Square behind a pawn that has just moved two squares, if
+    // an opponent pawn can capture there, otherwise NO_SQUARE
+    int enPassantSquare;
+
+    char operator[](const int index) const {
+        return squares[index];
+    }
+};
 
-const Move NO_MOVE = {-1, -1};
+
+// Random keys for Zobrist hashing, a position's key is the XOR of
+// the keys of its pieces, castling rights, en passant file and the
+// side to move
+namespace Zobrist {
+    extern uint64_t pieceKeys[2][6][64];
+    extern uint64_t castlingKeys[16];
+    extern uint64_t enPassantKeys[8];
+    extern uint64_t sideKey;
+}
+
+
+// Value of every piece on every square, positive for white and
+// negative for black. It is the material value of the piece plus
+// a weight for the square: pieces are stronger in the center,
+// kings are safer on the edges and pawns are worth more as they
+// advance, especially in the center
+namespace PieceSquareTables {
+    using Table = array<array<array<int, 64>, 6>, 2>;
+
+    // Builds the tables from the material values and weights,
+    // the compiler runs it, so the tables cost nothing at startup
+    constexpr Table build() {
+        const int materialValues[6] = {10, 30, 30, 50, 90, 150};
+
+        // A predefined weight for pawns
+        // Center pawns are favored
+        const int whitePawnWeights[64] = {
+            1, 2, 4, 5, 5, 4, 2, 1,
+            2, 3, 5, 6, 6, 5, 3, 2,
+            2, 3, 6, 7, 7, 6, 3, 2,
+            3, 4, 7, 8, 8, 7, 4, 3,
+            3, 4, 8, 9, 9, 8, 4, 3,
+            4, 5, 9, 10, 10, 9, 5, 4,
+            4, 5, 10, 11, 11, 10, 5, 4,
+            5, 6, 11, 12, 12, 11, 6, 5,
+        };
+
+        Table values{};
+        for (int square = 0; square < 64; square++) {
+            const int i = square / 8;
+            const int j = square % 8;
+
+            // Pieces are stronger in the center
+            // Kings are safer outside
+            const int ring = min(min(i, 7 - i), min(j, 7 - j));
+            const int pieceWeight = 2 + 2 * ring;
+            const int kingWeight = 8 - 2 * ring;
+
+            for (int type = PAWN; type <= KING; type++) {
+                // Black pawns are the same weights, but reversed
+                int whiteWeight = pieceWeight;
+                int blackWeight = pieceWeight;
+                if (type == KING) whiteWeight = blackWeight = kingWeight;
+                if (type == PAWN) {
+                    whiteWeight = whitePawnWeights[square];
+                    blackWeight = whitePawnWeights[63 - square];
+                }
+
+                values[WHITE][type][square] = materialValues[type] + whiteWeight;
+                values[BLACK][type][square] = -(materialValues[type] + blackWeight);
+            }
+        }
+        return values;
+    }
+
+    inline constexpr Table values = build();
+}
 
 
 // Namespace that holds functions that manipulate game board
@@ -24,21 +223,73 @@ namespace BoardFunctions {
     // Prints the board
     void printBoard(const Board& board);
 
-    // Returns the winner color if the game is over
-    // Game is over when opponent king is captured
-    Color isGameOver(const Board& board);
+    // Returns if the side to move is checkmated, stalemated
+    // or still has a legal move
+    GameState getGameState(const Board& board, Color turn);
 
     // Returns if a move is legal or not
+    bool isLegalMove(const Board& board, Move move, Color turn);
+
+    // Creates the move of a piece, with the flag the board needs
     // start is the square of piece to move
     // end is the square where the piece will move
-    bool isLegalMove(const Board& board, int start, int end, Color turn);
+    // promotion is the piece a pawn on the last rank becomes
+    Move createMove(const Board& board, int start, int end, PieceType promotion = QUEEN);
 
     // Makes a move
-    void makeMove(Board& board, int start, int end);
+    // Returns the information needed to take the move back
+    UndoInfo makeMove(Board& board, Move move);
+
+    // Takes back a move made by makeMove
+    void unmakeMove(Board& board, Move move, const UndoInfo& undo);
+
+    // Passes the turn without moving a piece, only the en passant
+    // square is lost. Used by the search for null move pruning
+    // Returns the information needed to take it back
+    UndoInfo makeNullMove(Board& board);
+
+    // Takes back a move made by makeNullMove
+    void unmakeNullMove(Board& board, const UndoInfo& undo);
 
-    // Returns all available moves of the colors turn
+    // Returns all legal moves of the colors turn
+    // Pinned pieces only move along their pin, and in check
+    // only the moves that answer the check are generated
     void getAllAvailableMoves(const Board& board, Moves& moves, Color turn);
 
+    // Returns the legal captures and queen promotions of the colors turn
+    void getAllAvailableCaptures(const Board& board, Moves& moves, Color turn);
+
+    // The same generators for a turn known at compile time, so the
+    // colors are folded into the code instead of branched on. The
+    // ones above pick the right one, the search calls these directly
+    template <Color Turn> void getAllAvailableMoves(const Board& board, Moves& moves);
+    template <Color Turn> void getAllAvailableCaptures(const Board& board, Moves& moves);
+
+    // Returns the pieces of both colors that attack the square,
+    // with occupied as the pieces that block sliding attacks
+    Bitboard getAttackers(const Board& board, int square, Bitboard occupied);
+
+    // Static exchange evaluation, the material the side to move wins
+    // when both sides keep capturing on the target square of the move
+    // with their least valuable piece, and either side may stop
+    // Returns a negative value for a losing capture
+    int staticExchange(const Board& board, Move move);
+
+    // Returns if a piece of the given color attacks the square
+    bool isSquareAttacked(const Board& board, int square, Color attacker);
+
+    // Returns if the king of the given color is under attack
+    bool isInCheck(const Board& board, Color color);
+
+    // Returns the hash key of the position for the given turn
+    uint64_t getHashKey(const Board& board, Color turn);
+
+    // Removes all the pieces, castling rights and the en passant square
+    void clearBoard(Board& board);
+
+    // Places a piece on an empty square
+    void putPiece(Board& board, char piece, int index);
+
     // Populates the board
     // Lowercase characters represent white,
     // uppercase characters represent black pieces
@@ -47,6 +298,18 @@ namespace BoardFunctions {
     // q -> queen | k -> king   | p -> pawn
     void populateBoard(Board& board);
 
+    // Sets the board up from a FEN string, and sets the turn
+    // to its side to move. The move counters are ignored
+    // Returns false if the FEN is invalid or its position can't
+    // come up in a game, like a missing king or a pawn on the last rank
+    bool loadFen(Board& board, const string& fen, Color& turn);
+
+    // Returns the color of a piece character
+    Color getColor(char piece);
+
+    // Returns the type of a piece character
+    PieceType getPieceType(char piece);
+
     // Converts a given index to chess notation
     // Example -> 0 = a1, 12 = e2
     string convertIndexToNotation(int index);
@@ -54,7 +317,25 @@ namespace BoardFunctions {
     // Converts a given notation to index
     // Example -> a1 = 0, e2 = 12
     int convertNotationToIndex(const string& notation);
+
+    // Converts a move to its notation without the space, with
+    // the promoted piece at the end
+    // Example -> e2 to e4 = e2e4, e7 to e8 as a knight = e7e8n
+    string convertMoveToNotation(Move move);
+
+    // Reads a move of the colors turn in the notation above
+    // Returns NO_MOVE if it isn't a legal move
+    Move convertNotationToMove(const Board& board, const string& notation, Color turn);
+
+    // Converts a line of moves to their notations separated by spaces
+    // Example -> e2e4 e7e5 g1f3
+    string convertLineToNotation(const vector<Move>& line);
+
+    // Converts a legal move of the colors turn to standard algebraic
+    // notation, as PGN files write it, before the move is made
+    // Example -> e2e4 = e4, g1f3 = Nf3, e7e8q with mate = e8=Q#
+    string convertMoveToSan(const Board& board, Move move, Color turn);
 }
 
 
-#endif //CHESS_BOARDFUNCTIONS_H
\ No newline at end of file
+#endif //CHESS_BOARDFUNCTIONS_H
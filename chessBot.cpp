@@ -6,186 +6,828 @@
 #include "chessBot.h"
 
 #include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <omp.h>
+#include <sstream>
 
 using namespace BoardFunctions;
 
-Color getColor(const char piece) {
-    if (piece == '0') return EMPTY;
-    return islower(piece) ? WHITE : BLACK;
+// Ordering scores that put the previous line, captures
+// and killers ahead of the history scores of quiet moves
+const int PV_MOVE_SCORE = (1 << 30) + 1;
+const int HASH_MOVE_SCORE = 1 << 30;
+const int CAPTURE_SCORE = 1 << 29;
+const int KILLER_SCORE = 1 << 28;
+
+// Half width of the first aspiration window, a tenth of a pawn
+const int ASPIRATION_WINDOW = 5;
+
+// Null moves are searched this much shallower, and one more ply
+// shallower from NULL_MOVE_DEEP_DEPTH on
+const int NULL_MOVE_REDUCTION = 2;
+const int NULL_MOVE_DEEP_DEPTH = 7;
+
+// Futility pruning is used this many plies from the leaves, with a
+// margin of one and a half pawns per ply
+const int FUTILITY_DEPTH = 2;
+const int FUTILITY_MARGIN = 15;
+
+// Late move reductions start at this depth and move number
+const int REDUCTION_DEPTH = 3;
+const int REDUCTION_MOVE = 3;
+
+namespace {
+    // Plies a late quiet move is reduced by, by depth and move number
+    // The later the move and the deeper the search, the less likely
+    // a move is to be best, so it is reduced more
+    int reductions[MAX_PLY][MAX_MOVES];
+
+    struct Initializer {
+        Initializer() {
+            for (int depth = 1; depth < MAX_PLY; depth++) {
+                for (int move = 1; move < MAX_MOVES; move++) {
+                    reductions[depth][move] = static_cast<int>(0.75 + log(depth) * log(move) / 2.25);
+                }
+            }
+        }
+    } initializer;
+}
+
+// Mate scores are stored relative to the stored position
+// instead of the root, so they stay correct at any ply
+int scoreToTable(const int score, const int ply) {
+    if (score > MATE_BOUND) return score + ply;
+    if (score < -MATE_BOUND) return score - ply;
+    return score;
+}
+
+int scoreFromTable(const int score, const int ply) {
+    if (score > MATE_BOUND) return score - ply;
+    if (score < -MATE_BOUND) return score + ply;
+    return score;
+}
+
+int movesToMate(const int score) {
+    if (abs(score) <= MATE_BOUND) return 0;
+
+    // The score is reduced by the plies until mate, so the
+    // mating side's moves are half of them, rounded up
+    const int moves = (MATE_SCORE - abs(score) + 1) / 2;
+    return score > 0 ? moves : -moves;
+}
+
+// Score of a tablebase result at the given ply, counted like the search counts mates
+int tablebaseScore(const TablebaseResult& result, const int ply) {
+    if (result.outcome == TB_DRAW) return 0;
+    const int score = MATE_SCORE - ply - result.plies;
+    return result.outcome == TB_WIN ? score : -score;
+}
+
+
+ChessBot::ChessBot(const size_t hashMegabytes) : table_(hashMegabytes) {
+    stop_ = false;
+    completedDepth_ = 0;
+    setThreads(omp_get_max_threads());
+}
+
+int ChessBot::evaluate(const Board &board, const Color turn) const {
+    if (network_) {
+        const int score = clamp(network_->evaluate(board, turn), -MATE_BOUND + 1, MATE_BOUND - 1);
+        return turn == WHITE ? score : -score;
+    }
+
+    // The board keeps the sum of the piece values with their
+    // according weights up to date with every move
+    return board.evaluation + PawnStructure::evaluate(board);
 }
 
-void attemptPromotion(Board& board, const int start, const int end) {
-    const int y = end / 8;
+double SearchStats::nodesPerSecond() const {
+    return static_cast<double>(nodes) * 1000 / max<int64_t>(milliseconds, 1);
+}
+
+double SearchStats::branchingFactor() const {
+    if (iterations.size() < 2) return 0;
+    const uint64_t previous = iterations[iterations.size() - 2].nodes;
+    return previous ? static_cast<double>(iterations.back().nodes) / previous : 0;
+}
 
-    const Color piece_color = getColor(board[start]);
+double SearchStats::firstMoveCutoffRate() const {
+    return cutoffs ? static_cast<double>(firstMoveCutoffs) / cutoffs : 0;
+}
 
-    if ((piece_color == WHITE && y == 7) || (piece_color == BLACK && y == 0)) {
-        board[start] = piece_color == WHITE ? 'q' : 'Q';
+string SearchStats::toJson() const {
+    ostringstream json;
+    json << fixed << setprecision(3)
+         << "{\"nodes\":" << nodes << ",\"qnodes\":" << quiescenceNodes
+         << ",\"time\":" << milliseconds << ",\"nps\":" << static_cast<uint64_t>(nodesPerSecond())
+         << ",\"ebf\":" << branchingFactor() << ",\"firstMoveCutoffRate\":" << firstMoveCutoffRate()
+         << ",\"hashHitRate\":" << hash.hitRate() << ",\"pawnHashHitRate\":" << pawnHash.hitRate()
+         << ",\"iterations\":[";
+    for (size_t i = 0; i < iterations.size(); i++) {
+        json << (i ? "," : "") << "{\"depth\":" << iterations[i].depth << ",\"nodes\":" << iterations[i].nodes
+             << ",\"time\":" << iterations[i].milliseconds << "}";
     }
+    json << "],\"threadNodes\":[";
+    for (size_t i = 0; i < threadNodes.size(); i++) json << (i ? "," : "") << threadNodes[i];
+    json << "]}";
+    return json.str();
 }
 
-Board makeMove_(Board board, const int start, const int end) {
-    if (tolower(board[start]) == 'p') attemptPromotion(board, start, end);
-    board[end] = board[start];
-    board[start] = '0';
-    return board;
+SearchStats ChessBot::stats() const {
+    SearchStats stats;
+    for (const auto& data : threadData_) {
+        const uint64_t nodes = data->nodes.load(memory_order_relaxed);
+        stats.nodes += nodes;
+        stats.quiescenceNodes += data->quiescenceNodes;
+        stats.cutoffs += data->cutoffs;
+        stats.firstMoveCutoffs += data->firstMoveCutoffs;
+        stats.hash += data->hash;
+        stats.pawnHash += data->pawnHash;
+        stats.threadNodes.push_back(nodes);
+    }
+    stats.milliseconds = searchMilliseconds_;
+    stats.iterations = iterations_;
+    return stats;
 }
 
+void ChessBot::setHashSize(const size_t megabytes) {
+    table_.resize(megabytes);
+}
 
-ChessBot::ChessBot() {
-    moveCounter_ = 0;
-    pieceWeights_.reserve(64);
-    kingWeights_.reserve(64);
+void ChessBot::setPawnHashSize(const size_t kilobytes) {
+    pawnHashKilobytes_ = kilobytes;
+    for (const auto& data : threadData_) data->pawnTable.resize(kilobytes);
+}
 
-    // A predefined weight for pawns
-    // Center pawns are favored
-    whitePawnWeights_ = {
-        1, 2, 4, 5, 5, 4, 2, 1,
-        2, 3, 5, 6, 6, 5, 3, 2,
-        2, 3, 6, 7, 7, 6, 3, 2,
-        3, 4, 7, 8, 8, 7, 4, 3,
-        3, 4, 8, 9, 9, 8, 4, 3,
-        4, 5, 9, 10, 10, 9, 5, 4,
-        4, 5, 10, 11, 11, 10, 5, 4,
-        5, 6, 11, 12, 12, 11, 6, 5,
-    };
+void ChessBot::setThreads(const int threads) {
+    threadData_.clear();
+    for (int i = 0; i < max(1, threads); i++) {
+        threadData_.push_back(make_unique<SearchData>());
+        threadData_.back()->id = i;
+        threadData_.back()->pawnTable.resize(pawnHashKilobytes_);
+    }
+}
 
-    // Black pawns are the same weights, but reversed
-    blackPawnWeights_ = whitePawnWeights_;
-    reverse(blackPawnWeights_.begin(), blackPawnWeights_.end());
+int ChessBot::threads() const {
+    return static_cast<int>(threadData_.size());
+}
 
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            // Pieces are stronger in the center
-            // Kings are safer outside
-            if (i == 0 || j == 0 || i == 7 || j == 7) {
-                pieceWeights_.push_back(2);
-                kingWeights_.push_back(8);
-                continue;
-            }
-            if (i == 1 || j == 1 || i == 6 || j == 6) {
-                pieceWeights_.push_back(4);
-                kingWeights_.push_back(6);
-                continue;
-            }
-            if (i == 2 || j == 2 || i == 5 || j == 5) {
-                pieceWeights_.push_back(6);
-                kingWeights_.push_back(4);
-                continue;
-            }
-            if (i == 3 || j == 3 || i == 4 || j == 4) {
-                pieceWeights_.push_back(8);
-                kingWeights_.push_back(2);
-            }
+void ChessBot::setPruning(const PruningOptions& pruning) {
+    pruning_ = pruning;
+}
+
+int ChessBot::completedDepth() const {
+    return completedDepth_;
+}
+
+void ChessBot::setInfoCallback(function<void(const SearchInfo&)> callback) {
+    infoCallback_ = std::move(callback);
+}
+
+void ChessBot::setBook(const OpeningBook* book, const BookSelection selection) {
+    book_ = book;
+    bookSelection_ = selection;
+}
+
+bool ChessBot::playedFromBook() const {
+    return playedFromBook_;
+}
+
+void ChessBot::setTablebases(const Tablebases* tablebases) {
+    tablebases_ = tablebases;
+}
+
+bool ChessBot::playedFromTablebase() const {
+    return playedFromTablebase_;
+}
+
+void ChessBot::setNetwork(const Network* network) {
+    network_ = network;
+}
+
+void ChessBot::clearHash() {
+    table_.clear();
+    principalVariation_.clear();
+    lineKeys_.clear();
+}
+
+vector<Move> ChessBot::principalVariation() const {
+    return principalVariation_;
+}
+
+vector<RootLine> ChessBot::rootLines() const {
+    return rootLines_;
+}
+
+void ChessBot::checkLimits() {
+    // The first depth always finishes, so there is a move to play
+    if (completedDepth_ == 0) return;
+
+    if (limits_.stop && limits_.stop->load(memory_order_relaxed)) stop_ = true;
+
+    // The clock starts again for as long as the search is pondering
+    if (limits_.ponder && limits_.ponder->load(memory_order_relaxed)) {
+        startTime_ = chrono::steady_clock::now();
+        return;
+    }
+
+    if (limits_.milliseconds > 0) {
+        const auto elapsed = chrono::steady_clock::now() - startTime_;
+        if (elapsed >= chrono::milliseconds(limits_.milliseconds)) stop_ = true;
+    }
+
+    if (limits_.nodes > 0) {
+        uint64_t nodes = 0;
+        for (const auto& data : threadData_) nodes += data->nodes.load(memory_order_relaxed);
+        if (nodes >= limits_.nodes) stop_ = true;
+    }
+}
+
+void ChessBot::SearchData::countNode() {
+    // Only this thread writes the counter, so a plain
+    // load and store is enough and nothing is locked
+    nodes.store(nodes.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+Move ChessBot::SearchData::previousPvMove(const int ply) const {
+    return followPly >= ply && ply < previousLength ? previousPv[ply] : NO_MOVE;
+}
+
+void ChessBot::SearchData::updatePv(const int ply, const Move move) {
+    pv[ply][ply] = move;
+    for (int i = ply + 1; i < pvLength[ply + 1]; i++) pv[ply][i] = pv[ply + 1][i];
+    pvLength[ply] = pvLength[ply + 1];
+}
+
+void ChessBot::SearchData::newSearch() {
+    nodes.store(0, memory_order_relaxed);
+    quiescenceNodes = cutoffs = firstMoveCutoffs = 0;
+    previousLength = followPly = 0;
+    rootLines.clear();
+    hash = {};
+    pawnHash = {};
+    for (auto& plyKillers : killers) {
+        plyKillers[0] = plyKillers[1] = NO_MOVE;
+    }
+
+    // Older history is still useful, but counts less
+    for (auto& colorHistory : history) {
+        for (auto& starts : colorHistory) {
+            for (int& value : starts) value /= 2;
         }
     }
 }
 
-int ChessBot::evaluate(const Board &board) const {
-    // Checkmate check
-    const Color game_state = isGameOver(board);
-    if (game_state != EMPTY) return game_state == WHITE ? 10000 : -10000;
+template <Color Turn>
+void ChessBot::scoreMoves(const Board &board, const Moves &moves, int scores[],
+                          const int ply, const Move hashMove, const SearchData &data) const {
+    const Move pvMove = data.previousPvMove(ply);
+    for (int i = 0; i < moves.size(); i++) {
+        const int start = moves[i].start();
+        const int end = moves[i].end();
+        const PieceType attacker = getPieceType(board[start]);
+        const PieceType victim = moves[i].flag() == EN_PASSANT ? PAWN : getPieceType(board[end]);
 
-    // Add the points for each piece with their according weights to evaluation
-    // White pieces are added, black pieces are subtracted
-    int evaluation = 0;
-    for (int i = 0; i < 64; i++) {
-        if (board[i] == '0') continue;
-        const Color piece_color = islower(board[i]) ? WHITE : BLACK;
-        int piece_value = 0;
-        switch (tolower(board[i])) {
-            case 'r':
-                piece_value = 50 + pieceWeights_[i];
-                break;
-            case 'n':
-                piece_value = 30 + pieceWeights_[i];
-                break;
-            case 'b':
-                piece_value = 30 + pieceWeights_[i];
-                break;
-            case 'q':
-                piece_value = 90 + pieceWeights_[i];
-                break;
-            case 'k':
-                piece_value = 150 + kingWeights_[i];
-                break;
-            case 'p':
-                piece_value = 10 + (piece_color == WHITE ? whitePawnWeights_[i] : blackPawnWeights_[i]);
-                break;
-            default:
-                break;
+        if (moves[i] == pvMove) {
+            scores[i] = PV_MOVE_SCORE;
+        }
+        else if (moves[i] == hashMove) {
+            scores[i] = HASH_MOVE_SCORE;
+        }
+        // Promoting to anything but a queen is rarely
+        // better, so those moves are tried last
+        else if (moves[i].isPromotion() && moves[i].promotion() != QUEEN) {
+            scores[i] = -KILLER_SCORE + moves[i].promotion();
+        }
+        else if (victim != NO_PIECE) {
+            scores[i] = CAPTURE_SCORE + 8 * victim - attacker;
+        }
+        else if (moves[i].isPromotion()) {
+            scores[i] = CAPTURE_SCORE;
+        }
+        else if (moves[i] == data.killers[ply][0]) {
+            scores[i] = KILLER_SCORE;
+        }
+        else if (moves[i] == data.killers[ply][1]) {
+            scores[i] = KILLER_SCORE - 1;
+        }
+        else {
+            scores[i] = data.history[Turn][start][end];
         }
-        evaluation += piece_color == WHITE ? piece_value : -1 * piece_value;
     }
+}
 
-    return evaluation;
+void ChessBot::pickMove(Moves &moves, int scores[], const int index) {
+    // Selection sort one step at a time, as most nodes
+    // are cut off after the first few moves
+    int best = index;
+    for (int i = index + 1; i < moves.size(); i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    swap(moves[index], moves[best]);
+    swap(scores[index], scores[best]);
 }
 
-int ChessBot::movesMade() {
-    // Return the moves made and reset the counter
-    const int temp = moveCounter_;
-    moveCounter_ = 0;
-    return temp;
+void ChessBot::playMove(Board &board, const Move move, const int ply, SearchData &data) const {
+    data.undoStack[ply] = makeMove(board, move);
+
+    // The line of the last depth is followed as long as every move so far was on it
+    if (data.followPly >= ply) data.followPly = data.previousPvMove(ply) == move ? ply + 1 : ply;
+    if (network_) network_->update(board, move, data.undoStack[ply], data.accumulators[ply], data.accumulators[ply + 1]);
 }
 
-pair<int, Move> ChessBot::minimax(Board board, const int depth, const Color turn) {
-    // For counting the moves, negatively affects the performance
-    // Can be removed if someone wants a faster algorithm
-    #pragma omp critical
-    {
-        moveCounter_++;
+template <Color Turn>
+int ChessBot::staticEvaluation(const Board &board, const int ply, SearchData &data) const {
+    // Network scores stay clear of the mate scores
+    if (network_) return clamp(network_->evaluate(data.accumulators[ply], Turn), -MATE_BOUND + 1, MATE_BOUND - 1);
+    const int score = board.evaluation + data.pawnTable.evaluate(board, data.pawnHash);
+    return Turn == WHITE ? score : -score;
+}
+
+template <Color Turn, NodeType Node>
+int ChessBot::alphaBeta(Board &board, const int depth, const int ply, int alpha, const int beta,
+                        const bool allowNull, SearchData &data) {
+    constexpr Color opponent = Turn == WHITE ? BLACK : WHITE;
+    data.countNode();
+    data.pvLength[ply] = ply;
+
+    // The main thread looks at the clock every 1024 moves
+    if (data.id == 0 && (data.nodes.load(memory_order_relaxed) & 1023) == 0) checkLimits();
+
+    // The search is over, this result won't be used
+    if (stop_.load(memory_order_relaxed)) return 0;
+
+    // Endings in the tablebases are already solved
+    TablebaseResult tablebaseResult;
+    if (tablebases_ && Bitboards::popCount(board.occupied) <= Tablebases::MAX_PIECES &&
+        tablebases_->probe(board, Turn, tablebaseResult)) {
+        return tablebaseScore(tablebaseResult, ply);
     }
 
-    // Base recursion case
-    if (isGameOver(board) != EMPTY || depth == 0) {
-        return {evaluate(board), NO_MOVE};
+    // Base recursion case, the captures are played out first
+    if (depth <= 0 || ply >= MAX_PLY - 1) return quiescence<Turn>(board, ply, alpha, beta, data);
+
+    // A result of the same position may already be stored, either
+    // deep enough to be used directly or at least with a good move
+    // PV nodes always search, so their line is complete
+    const uint64_t key = getHashKey(board, Turn);
+    Move hashMove = NO_MOVE;
+    TTEntry entry{};
+    data.hash.probes++;
+    if (table_.probe(key, entry)) {
+        data.hash.hits++;
+        hashMove = entry.move;
+
+        if (Node == NON_PV_NODE && entry.depth >= depth) {
+            const int score = scoreFromTable(entry.score, ply);
+            if (entry.bound == BOUND_EXACT ||
+                (entry.bound == BOUND_LOWER && score >= beta) ||
+                (entry.bound == BOUND_UPPER && score <= alpha)) {
+                return score;
+            }
+        }
     }
 
-    pair<int, Move> best;
+    // The selective search is turned off in check, where every move matters
+    const bool inCheck = isInCheck(board, Turn);
+    const bool selective = !inCheck;
+    const int evaluation = selective ? staticEvaluation<Turn>(board, ply, data) : 0;
+
+    // Null move pruning: if the position is still too good for the opponent
+    // after passing the turn, a real move would be even better. With only
+    // pawns left, passing can be better than any move (zugzwang), so it
+    // isn't tried then. A mate can't be proven by passing either
+    // PV nodes are expected to end inside the window, so they never pass
+    const Bitboard pieces = board.colors[Turn] & ~(board.pieces[Turn][PAWN] | board.pieces[Turn][KING]);
+    if (Node == NON_PV_NODE && pruning_.nullMove && allowNull && selective && depth >= NULL_MOVE_REDUCTION + 1 &&
+        abs(beta) < MATE_BOUND && evaluation >= beta && pieces) {
+        const int reduction = NULL_MOVE_REDUCTION + (depth >= NULL_MOVE_DEEP_DEPTH);
+        data.undoStack[ply] = makeNullMove(board);
+        if (data.followPly >= ply) data.followPly = ply;
+        if (network_) data.accumulators[ply + 1] = data.accumulators[ply];
+        const int score = -alphaBeta<opponent, NON_PV_NODE>(board, depth - 1 - reduction, ply + 1,
+                                                            -beta, -beta + 1, false, data);
+        unmakeNullMove(board, data.undoStack[ply]);
+        if (stop_.load(memory_order_relaxed)) return 0;
+        if (score >= beta) return score >= MATE_BOUND ? beta : score;
+    }
+
+    // All the available moves for the given turn, kept
+    // on the stack so that nodes don't allocate
     Moves availableMoves;
+    int scores[MAX_MOVES];
+    getAllAvailableMoves<Turn>(board, availableMoves);
+
+    // No legal move is either checkmate, found closer to the root
+    // the worse it is, or stalemate
+    if (availableMoves.empty()) return inCheck ? -MATE_SCORE + ply : 0;
+    scoreMoves<Turn>(board, availableMoves, scores, ply, hashMove, data);
+
+    const int originalAlpha = alpha;
+    Move bestMove = NO_MOVE;
+    int best = -MATE_SCORE - 1;
 
-    // All the available moves for the given turn
-    getAllAvailableMoves(board, availableMoves, turn);
+    // Next to the leaves, quiet moves can't make up for an evaluation
+    // that is far below alpha, unless alpha is a mate score
+    const bool futile = pruning_.futility && selective && depth <= FUTILITY_DEPTH && abs(alpha) < MATE_BOUND &&
+                        evaluation + FUTILITY_MARGIN * depth <= alpha;
 
-    // The moves for all the moves are evaluated, and then the best performing move is made
-    if (turn == WHITE) {
-        best = {-10000, NO_MOVE};
+    for (int i = 0; i < availableMoves.size(); i++) {
+        pickMove(availableMoves, scores, i);
+        const Move move = availableMoves[i];
+        const bool quiet = board[move.end()] == '0' && move.flag() != EN_PASSANT && !move.isPromotion();
 
-        int i;
+        // Killers are quiet, but they are ordered early for a reason
+        const bool late = pruning_.lateMoveReductions && selective && quiet && depth >= REDUCTION_DEPTH &&
+                          i >= REDUCTION_MOVE && scores[i] < KILLER_SCORE - 1;
+
+        playMove(board, move, ply, data);
+
+        // Moves that give check are never pruned or reduced
+        const bool givesCheck = (late || (futile && quiet)) && isInCheck(board, opponent);
+        if (futile && quiet && i > 0 && !givesCheck) {
+            unmakeMove(board, move, data.undoStack[ply]);
+            continue;
+        }
 
-        #pragma omp parallel for default(none) firstprivate(depth, board) shared(best, availableMoves)
-        for (i = 0; i < availableMoves.size(); i++) {
-            const Move move = availableMoves[i];
-            const Board newBoard = makeMove_(board, move.first, move.second);
-            const pair<int, Move> newBest = {minimax(newBoard, depth - 1, BLACK).first, move};
-            #pragma omp critical
-            {
-                if (newBest.first > best.first) {
-                    best = newBest;
+        // Principal variation search: the first move gets the full window,
+        // the rest a null window around alpha, and a (reduced) move that
+        // beats alpha anyway is searched again at full depth and then,
+        // at PV nodes, with the full window
+        int score;
+        if (i == 0) {
+            score = -alphaBeta<opponent, Node>(board, depth - 1, ply + 1, -beta, -alpha, true, data);
+        }
+        else {
+            const int reduction = late && !givesCheck ? min(reductions[depth][i], depth - 2) : 0;
+            score = -alphaBeta<opponent, NON_PV_NODE>(board, depth - 1 - reduction, ply + 1,
+                                                      -alpha - 1, -alpha, true, data);
+            if (score > alpha && reduction > 0) {
+                score = -alphaBeta<opponent, NON_PV_NODE>(board, depth - 1, ply + 1, -alpha - 1, -alpha, true, data);
+            }
+            if (Node == PV_NODE && score > alpha && score < beta) {
+                score = -alphaBeta<opponent, PV_NODE>(board, depth - 1, ply + 1, -beta, -alpha, true, data);
+            }
+        }
+        unmakeMove(board, move, data.undoStack[ply]);
+        if (stop_.load(memory_order_relaxed)) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = move;
+        }
+        if (score > alpha) {
+            alpha = score;
+            if (Node == PV_NODE) data.updatePv(ply, move);
+        }
+
+        // The opponent will not allow this position, the rest can be skipped
+        if (alpha >= beta) {
+            data.cutoffs++;
+            if (i == 0) data.firstMoveCutoffs++;
+            if (quiet) {
+                if (data.killers[ply][0] != move) {
+                    data.killers[ply][1] = data.killers[ply][0];
+                    data.killers[ply][0] = move;
+                }
+
+                // Keep the history below the capture and killer scores
+                int& history = data.history[Turn][move.start()][move.end()];
+                history += depth * depth;
+                if (history > KILLER_SCORE / 2) {
+                    for (auto& starts : data.history[Turn]) {
+                        for (int& value : starts) value /= 2;
+                    }
                 }
             }
+            break;
         }
     }
 
-    if (turn == BLACK) {
-        best = {10000, NO_MOVE};
+    const Bound bound = best <= originalAlpha ? BOUND_UPPER : best >= beta ? BOUND_LOWER : BOUND_EXACT;
+    data.hash.stores++;
+    if (table_.store(key, depth, bound, scoreToTable(best, ply), bestMove)) data.hash.overwrites++;
+
+    return best;
+}
+
+template <Color Turn>
+int ChessBot::quiescence(Board &board, const int ply, int alpha, const int beta, SearchData &data) {
+    constexpr Color opponent = Turn == WHITE ? BLACK : WHITE;
+    data.countNode();
+    data.quiescenceNodes++;
+
+    // The lines end where the quiescence search starts
+    data.pvLength[ply] = ply;
+    if (data.id == 0 && (data.nodes.load(memory_order_relaxed) & 1023) == 0) checkLimits();
+    if (stop_.load(memory_order_relaxed)) return 0;
+
+    // Captures often go down into the tablebases
+    TablebaseResult tablebaseResult;
+    if (tablebases_ && Bitboards::popCount(board.occupied) <= Tablebases::MAX_PIECES &&
+        tablebases_->probe(board, Turn, tablebaseResult)) {
+        return tablebaseScore(tablebaseResult, ply);
+    }
+
+    const int evaluation = staticEvaluation<Turn>(board, ply, data);
+    if (ply >= MAX_PLY - 1) return evaluation;
 
-        int i;
+    // Standing pat, the side to move doesn't have to capture
+    // unless its king is attacked
+    const bool inCheck = isInCheck(board, Turn);
+    int best = -MATE_SCORE - 1;
+    if (!inCheck) {
+        if (evaluation >= beta) return evaluation;
+        if (evaluation > alpha) alpha = evaluation;
+        best = evaluation;
+    }
+
+    Moves availableMoves;
+    int scores[MAX_MOVES];
+    if (inCheck) getAllAvailableMoves<Turn>(board, availableMoves);
+    else getAllAvailableCaptures<Turn>(board, availableMoves);
+    if (inCheck && availableMoves.empty()) return -MATE_SCORE + ply;
+    scoreMoves<Turn>(board, availableMoves, scores, ply, NO_MOVE, data);
+
+    for (int i = 0; i < availableMoves.size(); i++) {
+        pickMove(availableMoves, scores, i);
+        const Move move = availableMoves[i];
+
+        // Losing captures rarely turn out well, not searching
+        // them keeps the quiescence search small
+        if (!inCheck && staticExchange(board, move) < 0) continue;
+
+        playMove(board, move, ply, data);
+        const int score = -quiescence<opponent>(board, ply + 1, -beta, -alpha, data);
+        unmakeMove(board, move, data.undoStack[ply]);
+        if (stop_.load(memory_order_relaxed)) return 0;
+
+        if (score > best) best = score;
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) break;
+    }
+    return best;
+}
+
+template <Color Turn>
+pair<int, Move> ChessBot::searchRoot(Board &board, const int depth, const int alpha, const int beta,
+                                     SearchData &data) {
+    constexpr Color opponent = Turn == WHITE ? BLACK : WHITE;
+    data.countNode();
+    data.pvLength[0] = 0;
+    data.followPly = 0;
+
+    Moves availableMoves;
+    int scores[MAX_MOVES];
 
-        #pragma omp parallel for default(none) firstprivate(depth, board) shared(best, availableMoves)
-        for (i = 0; i < availableMoves.size(); i++) {
-            const Move move = availableMoves[i];
-            const Board newBoard = makeMove_(board, move.first, move.second);
-            const pair<int, Move> newBest = {minimax(newBoard, depth - 1, WHITE).first, move};
-            #pragma omp critical
-            {
-                if (newBest.first < best.first) {
-                    best = newBest;
+    const uint64_t key = getHashKey(board, Turn);
+    TTEntry entry{};
+    const Move hashMove = table_.probe(key, entry) ? entry.move : NO_MOVE;
+    if (network_) network_->refresh(board, data.accumulators[0]);
+    getAllAvailableMoves<Turn>(board, availableMoves);
+    scoreMoves<Turn>(board, availableMoves, scores, 0, hashMove, data);
+
+    // The best moves of the last depth are tried first, in their order,
+    // so the lines fill up with good moves and the rest are cut off sooner
+    const size_t lineCount = max(limits_.multiPv, 1);
+    if (lineCount > 1) {
+        for (size_t line = 0; line < data.rootLines.size(); line++) {
+            for (int i = 0; i < availableMoves.size(); i++) {
+                if (availableMoves[i] == data.rootLines[line].pv[0]) {
+                    scores[i] = PV_MOVE_SCORE + static_cast<int>(lineCount - line);
                 }
             }
         }
     }
+    data.rootLines.clear();
+
+    pair<int, Move> best = {-MATE_SCORE, NO_MOVE};
+
+    for (int i = 0; i < availableMoves.size(); i++) {
+        pickMove(availableMoves, scores, i);
+        const Move move = availableMoves[i];
+
+        // Until there are enough lines every move gets the full window, so its
+        // score is exact. After that a null window only proves the move worse
+        // than the last line, and a move that isn't is searched again. With a
+        // single line, the moves after the first always get the null window,
+        // even when the first one failed low
+        const bool linesFull = data.rootLines.size() >= lineCount;
+        const int bound = linesFull ? max(alpha, data.rootLines.back().score) : alpha;
+
+        playMove(board, move, 0, data);
+        int score;
+        if (i == 0 || (lineCount > 1 && !linesFull)) {
+            score = -alphaBeta<opponent, PV_NODE>(board, depth - 1, 1, -beta, -bound, true, data);
+        }
+        else {
+            score = -alphaBeta<opponent, NON_PV_NODE>(board, depth - 1, 1, -bound - 1, -bound, true, data);
+            if (score > bound && score < beta) {
+                score = -alphaBeta<opponent, PV_NODE>(board, depth - 1, 1, -beta, -bound, true, data);
+            }
+        }
+        unmakeMove(board, move, data.undoStack[0]);
+        if (stop_.load(memory_order_relaxed)) break;
+
+        if (score > best.first) best = {score, move};
+        if (score > bound) {
+            // The line takes its place among the others, pushing out the last one
+            RootLine line = {score, {move}};
+            line.pv.insert(line.pv.end(), data.pv[1] + 1, data.pv[1] + data.pvLength[1]);
+            const auto place = find_if(data.rootLines.begin(), data.rootLines.end(),
+                                       [score](const RootLine& other) { return other.score < score; });
+            data.rootLines.insert(place, std::move(line));
+            if (data.rootLines.size() > lineCount) data.rootLines.pop_back();
+
+            if (best.second == move && score > alpha) data.updatePv(0, move);
+        }
+        if (score >= beta) break;
+    }
+
+    if (!stop_.load(memory_order_relaxed) && best.second != NO_MOVE) {
+        const Bound bound = best.first <= alpha ? BOUND_UPPER
+                            : best.first >= beta ? BOUND_LOWER : BOUND_EXACT;
+        table_.store(key, depth, bound, best.first, best.second);
+    }
     return best;
 }
 
+pair<int, Move> ChessBot::iterativeDeepening(Board &board, const Color turn, const int firstDepth,
+                                             const int lastDepth, SearchData &data) {
+    pair<int, Move> best = {-MATE_SCORE, NO_MOVE};
+
+    // Nodes of all the threads when the last depth was completed
+    uint64_t searchedNodes = 0;
+
+    for (int depth = firstDepth; depth <= lastDepth && !stop_; depth++) {
+        // The score rarely moves much between depths, so a narrow window
+        // around the last one cuts more. If the score falls outside,
+        // the window is widened on that side and the depth searched again.
+        // Lines after the first can be far below the best, so a MultiPV
+        // search always has the full window
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -MATE_SCORE - 1;
+        int beta = MATE_SCORE + 1;
+        if (depth >= 4 && limits_.multiPv <= 1) {
+            alpha = max(best.first - delta, -MATE_SCORE - 1);
+            beta = min(best.first + delta, MATE_SCORE + 1);
+        }
+
+        pair<int, Move> result;
+        while (true) {
+            result = turn == WHITE ? searchRoot<WHITE>(board, depth, alpha, beta, data)
+                                   : searchRoot<BLACK>(board, depth, alpha, beta, data);
+            if (stop_) break;
+
+            if (result.first <= alpha) alpha = max(alpha - delta, -MATE_SCORE - 1);
+            else if (result.first >= beta) beta = min(beta + delta, MATE_SCORE + 1);
+            else break;
+            delta *= 2;
+        }
+        if (stop_) break;
+
+        best = result;
+
+        // The next depth starts with this line
+        data.previousLength = data.pvLength[0];
+        copy(data.pv[0], data.pv[0] + data.pvLength[0], data.previousPv);
+
+        if (data.id == 0) {
+            completedDepth_ = depth;
+            principalVariation_.assign(data.pv[0], data.pv[0] + data.pvLength[0]);
+            rootLines_ = data.rootLines;
+
+            uint64_t nodes = 0;
+            for (const auto& threadData : threadData_) nodes += threadData->nodes.load(memory_order_relaxed);
+            const auto elapsed = chrono::steady_clock::now() - searchStart_;
+            iterations_.push_back({depth, nodes - searchedNodes,
+                                   chrono::duration_cast<chrono::milliseconds>(elapsed).count()});
+            searchedNodes = nodes;
+
+            if (infoCallback_) reportDepth(depth, best);
+        }
+    }
+    return best;
+}
+
+void ChessBot::reportDepth(const int depth, const pair<int, Move> &best) const {
+    SearchInfo info;
+    info.depth = depth;
+    info.score = best.first;
+    info.nodes = 0;
+    for (const auto& threadData : threadData_) info.nodes += threadData->nodes.load(memory_order_relaxed);
+    info.pv = principalVariation_;
+    info.lines = rootLines_;
+    infoCallback_(info);
+}
+
+pair<int, Move> ChessBot::minimax(Board board, const int depth, const Color turn) {
+    SearchLimits limits;
+    limits.depth = depth;
+    return search(board, turn, limits);
+}
+
+pair<int, Move> ChessBot::search(const Board &board, const Color turn, const SearchLimits &limits) {
+    table_.newSearch();
+    stop_ = false;
+    limits_ = limits;
+    startTime_ = searchStart_ = chrono::steady_clock::now();
+    completedDepth_ = 0;
+    playedFromBook_ = false;
+    playedFromTablebase_ = false;
+    iterations_.clear();
+    for (const auto& data : threadData_) data->newSearch();
+
+    // If the position is on the line the last search expected, usually
+    // after the predicted reply, the rest of the line is searched first
+    const uint64_t key = getHashKey(board, turn);
+    for (size_t i = 0; i < lineKeys_.size(); i++) {
+        if (lineKeys_[i] != key) continue;
+        for (const auto& data : threadData_) {
+            data->previousLength = static_cast<int>(principalVariation_.size() - i);
+            copy(principalVariation_.begin() + i, principalVariation_.end(), data->previousPv);
+        }
+        break;
+    }
+    principalVariation_.clear();
+    rootLines_.clear();
+
+    const pair<int, Move> result = searchPosition(board, turn);
+    const auto elapsed = chrono::steady_clock::now() - searchStart_;
+    searchMilliseconds_ = chrono::duration_cast<chrono::milliseconds>(elapsed).count();
+
+    lineKeys_.clear();
+    Board line = board;
+    Color side = turn;
+    for (const Move move : principalVariation_) {
+        lineKeys_.push_back(getHashKey(line, side));
+        makeMove(line, move);
+        side = side == WHITE ? BLACK : WHITE;
+    }
+    return result;
+}
+
+pair<int, Move> ChessBot::searchPosition(const Board &board, const Color turn) {
+
+    // A book move is played without searching
+    if (book_) {
+        const Move move = book_->probe(board, turn, bookSelection_);
+        if (move != NO_MOVE) {
+            playedFromBook_ = true;
+            principalVariation_ = {move};
+            const int score = evaluate(board, turn);
+            rootLines_ = {{turn == WHITE ? score : -score, {move}}};
+            return {score, move};
+        }
+    }
+
+    // So is the best move of a solved ending
+    if (tablebases_) {
+        TablebaseResult result;
+        const Move move = tablebases_->bestMove(board, turn, result);
+        if (move != NO_MOVE) {
+            playedFromTablebase_ = true;
+            principalVariation_ = {move};
+            const int score = tablebaseScore(result, 0);
+            rootLines_ = {{score, {move}}};
+            return {turn == WHITE ? score : -score, move};
+        }
+    }
+
+    // Base recursion case, a finished game has no move to play
+    const GameState state = getGameState(board, turn);
+    if (state != ONGOING || limits_.depth <= 0) {
+        threadData_[0]->countNode();
+        if (state == STALEMATE) return {0, NO_MOVE};
+        if (state == CHECKMATE) return {turn == WHITE ? -MATE_SCORE : MATE_SCORE, NO_MOVE};
+        return {evaluate(board, turn), NO_MOVE};
+    }
+
+    pair<int, Move> best = {-MATE_SCORE, NO_MOVE};
+
+    // Lazy SMP: every thread searches the same position with iterative
+    // deepening, and they help each other through the shared transposition
+    // table. Half of the helpers are a ply ahead, so the threads spread over
+    // different parts of the tree. Only the main thread's result is used,
+    // and the helpers stop as soon as it is done.
+    #pragma omp parallel num_threads(threads()) default(none) shared(board, turn, best)
+    {
+        const int id = omp_get_thread_num();
+        SearchData &data = *threadData_[id];
+        Board threadBoard = board;
+
+        if (id == 0) {
+            best = iterativeDeepening(threadBoard, turn, 1, limits_.depth, data);
+            stop_ = true;
+        }
+        else {
+            iterativeDeepening(threadBoard, turn, 1 + id % 2, MAX_PLY - 1, data);
+        }
+    }
+
+    if (turn == BLACK) best.first = -best.first;
+    return best;
+}
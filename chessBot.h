@@ -6,38 +6,423 @@
 #ifndef CHESS_CHESSBOT_H
 #define CHESS_CHESSBOT_H
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 #include "boardFunctions.h"
+#include "nnue.h"
+#include "openingBook.h"
+#include "pawnStructure.h"
+#include "tablebases.h"
+#include "transpositionTable.h"
 
 using namespace std;
 
+// Score of a checkmate, found mates are
+// reduced by their distance to the root
+const int MATE_SCORE = 10000;
+
+// Maximum depth that the search can reach
+const int MAX_PLY = 64;
+
+// Scores closer to MATE_SCORE than this are mates, tablebase
+// mates can be much further away than the search reaches
+const int MATE_BOUND = MATE_SCORE - 512;
+
+// Nodes of the principal variation search. The first move of a PV node
+// is searched with the full window, as it is expected to be best, and
+// leads to another PV node. Every other move is only checked with a
+// null window to prove that it is worse, and is searched again with
+// the full window if it isn't. Non-PV nodes have a null window
+enum NodeType {PV_NODE, NON_PV_NODE};
+
+// Default size of the transposition table
+const size_t DEFAULT_HASH_MB = 16;
+
+// Returns the moves until mate of a mate score, negative when
+// the side to move is mated, or 0 if the score isn't a mate
+int movesToMate(int score);
+
+// Limits of a search, a zero time or node limit is not checked
+struct SearchLimits {
+    // Deepest iteration to search
+    int depth = MAX_PLY - 1;
+
+    // Thinking time in milliseconds
+    int64_t milliseconds = 0;
+
+    // Moves to analyse, summed over all the threads
+    uint64_t nodes = 0;
+
+    // Set from another thread to stop the search early
+    const atomic<bool>* stop = nullptr;
+
+    // While set from another thread, the time limit waits
+    // and only starts counting once it is cleared
+    const atomic<bool>* ponder = nullptr;
+
+    // Root moves that get an exact score and a line of their own
+    int multiPv = 1;
+};
+
+// Switches of the selective search, every technique is on by default
+// and can be turned off to measure what it gains
+struct PruningOptions {
+    // Passing the turn at a reduced depth, a position that is still
+    // too good for the opponent is cut off without searching its moves
+    bool nullMove = true;
+
+    // Quiet moves ordered late are searched less deep first,
+    // and again at the full depth if they beat the bound
+    bool lateMoveReductions = true;
+
+    // Quiet moves next to the leaves are skipped when the evaluation
+    // is so far below alpha that they can't bring it up
+    bool futility = true;
+};
+
+// One of the best root moves of a search with its line
+struct RootLine {
+    // Score from the point of view of the side to move
+    int score;
+
+    // Line starting with the root move
+    vector<Move> pv;
+};
+
+// Progress of a search, reported after every completed depth
+struct SearchInfo {
+    int depth;
+
+    // Score from the point of view of the side to move
+    int score;
+
+    // Moves analysed so far, summed over all the threads
+    uint64_t nodes;
+
+    // Best line found, starting with the move to play
+    vector<Move> pv;
+
+    // Lines of the best root moves, best first, as many as the
+    // MultiPV limit asks for. The first one is the line above
+    vector<RootLine> lines;
+};
+
+// Nodes and time of a depth the main thread completed
+struct IterationStats {
+    int depth;
+
+    // Nodes of all the threads while the depth was searched
+    uint64_t nodes;
+
+    // Time since the search started
+    int64_t milliseconds;
+};
+
+// Statistics of the last search, summed over all the threads
+// Every thread counts into its own data, so counting never contends
+struct SearchStats {
+    // Nodes of the whole search, quiescence nodes included
+    uint64_t nodes = 0;
+    uint64_t quiescenceNodes = 0;
+
+    int64_t milliseconds = 0;
+
+    // Cutoffs of the alpha-beta search, and how many of
+    // them came from the first move that was tried
+    uint64_t cutoffs = 0;
+    uint64_t firstMoveCutoffs = 0;
+
+    HashStats hash;
+
+    // Lookups of the pawn structure scores, only made
+    // without a network
+    HashStats pawnHash;
+
+    // Every depth the main thread completed, in order
+    vector<IterationStats> iterations;
+
+    // Nodes of every thread, the main thread first
+    vector<uint64_t> threadNodes;
+
+    double nodesPerSecond() const;
+
+    // Nodes of the last completed depth divided by the nodes
+    // of the depth before it, 0 with fewer than two depths
+    double branchingFactor() const;
+
+    // Share of the cutoffs the first move caused, the
+    // higher the better the moves are ordered
+    double firstMoveCutoffRate() const;
+
+    // Returns the statistics as a JSON object on one line
+    string toJson() const;
+};
+
 class ChessBot {
 public:
-    ChessBot();
+    explicit ChessBot(size_t hashMegabytes = DEFAULT_HASH_MB);
 
-    // Evaluates the board
-    // Adds the pieces values based on their weights
+    // Evaluates the board with the network, if one is set
+    // Otherwise adds the pieces values based on their weights
     // White pieces are added, black pieces are subtracted
-    int evaluate(const Board &board) const;
+    // The sum is kept on the board, so this takes constant time,
+    // and the score of the pawn structure is added to it
+    // The score is from white's point of view
+    int evaluate(const Board &board, Color turn) const;
 
-    // Counts how many moves are evaluated by the algorithm
-    int movesMade();
+    // Returns the statistics of the last search
+    SearchStats stats() const;
 
-    // The minimax algorithm
+    // Resizes the transposition table, clearing it
+    void setHashSize(size_t megabytes);
+
+    // Resizes the pawn hash table of every thread, clearing them
+    void setPawnHashSize(size_t kilobytes);
+
+    // Sets how many threads search together
+    void setThreads(int threads);
+    int threads() const;
+
+    // Turns the techniques of the selective search on or off
+    void setPruning(const PruningOptions& pruning);
+
+    // The minimax algorithm with alpha-beta pruning
     // The algorithm will run for all possible moves until the
     // given depth has been reached, then the best possible
-    // outcome is chosen and returned. Increasing the depth
-    // exponentially slows the algorithm, due to how chess works.
+    // outcome is chosen and returned. Branches that cannot change
+    // the result are cut off, so good move ordering matters.
+    // Increasing the depth still exponentially slows the
+    // algorithm, due to how chess works.
+    // The score is from white's point of view
     pair<int, Move> minimax(Board board, int depth, Color turn);
+
+    // Searches one depth deeper at a time until the depth limit is
+    // completed or the time or node budget runs out. A running depth
+    // is abandoned when the budget runs out or the search is stopped
+    // through the limits, and the best move of the last completed depth
+    // is returned. At least depth 1 is always completed. A move of the
+    // opening book is returned right away, with the static evaluation,
+    // and so is the best move of a position in the tablebases
+    // The score is from white's point of view
+    pair<int, Move> search(const Board &board, Color turn, const SearchLimits &limits);
+
+    // Returns the last depth the last search completed
+    int completedDepth() const;
+
+    // Sets the function called with the progress of the search
+    // after every depth the main thread completes
+    void setInfoCallback(function<void(const SearchInfo&)> callback);
+
+    // Sets the opening book that search plays from before searching,
+    // nullptr turns it off. The book isn't owned and has to stay open
+    void setBook(const OpeningBook* book, BookSelection selection = BOOK_WEIGHTED);
+
+    // Returns if the last search played a book move
+    bool playedFromBook() const;
+
+    // Sets the endgame tablebases probed at the root and inside the
+    // search, nullptr turns them off. They aren't owned
+    void setTablebases(const Tablebases* tablebases);
+
+    // Returns if the last search played a tablebase move
+    bool playedFromTablebase() const;
+
+    // Sets the network that evaluates positions instead of the
+    // piece-square tables, nullptr turns it off. It isn't owned
+    void setNetwork(const Network* network);
+
+    // Clears the transposition table, so a new game
+    // doesn't use results of the last one
+    void clearHash();
+
+    // Returns the line the last search expects, starting with the move
+    // it played, from the last depth the main thread completed. A book
+    // or tablebase move comes alone, and a finished game has no line
+    vector<Move> principalVariation() const;
+
+    // Returns the lines of the best root moves of the last search, best
+    // first, from the last depth the main thread completed. There are
+    // as many as the MultiPV limit asked for, or as there are legal moves
+    // A book or tablebase move is the only line
+    vector<RootLine> rootLines() const;
 private:
-    // Weights for different piece types
-    // All the pieces require a different set of weights
-    vector<int> pieceWeights_;
-    vector<int> kingWeights_;
-    vector<int> whitePawnWeights_;
-    vector<int> blackPawnWeights_;
-
-    // Counts the moves
-    int moveCounter_;
+    // Move ordering data, every search thread has its own
+    struct alignas(64) SearchData {
+        // Index of the thread, 0 is the main thread
+        int id;
+
+        // Moves counted by this thread
+        atomic<uint64_t> nodes;
+
+        // Quiescence nodes, cutoffs and transposition table usage
+        // of this thread, only read once the search is over
+        uint64_t quiescenceNodes;
+        uint64_t cutoffs;
+        uint64_t firstMoveCutoffs;
+        HashStats hash;
+        HashStats pawnHash;
+
+        // Pawn structure scores this thread has computed, they
+        // stay valid from one search to the next
+        PawnTable pawnTable;
+
+        // Quiet moves that caused a cutoff at each ply
+        Move killers[MAX_PLY][2];
+
+        // Cutoff scores of quiet moves by color, start and end square
+        int history[2][64][64];
+
+        // Undo information of the move made at each ply
+        UndoInfo undoStack[MAX_PLY];
+
+        // Network accumulator of the position at each ply
+        Accumulator accumulators[MAX_PLY + 1];
+
+        // Triangular table of the best lines: row ply holds the line
+        // from that ply, from column ply up to pvLength[ply]
+        Move pv[MAX_PLY + 1][MAX_PLY + 1];
+        int pvLength[MAX_PLY + 1];
+
+        // Line of the last completed depth, or the expected line of the
+        // last search, whose moves are tried first while the moves made
+        // so far follow it. They do up to ply followPly
+        Move previousPv[MAX_PLY];
+        int previousLength;
+        int followPly;
+
+        // Lines of the best root moves of the last root search, best first
+        vector<RootLine> rootLines;
+
+        // Returns the move of the previous line at the ply,
+        // or NO_MOVE if the search has left the line
+        Move previousPvMove(int ply) const;
+
+        // Stores the move followed by the line of the next ply as the line of the ply
+        void updatePv(int ply, Move move);
+
+        void countNode();
+
+        // Resets the data that only belongs to the last search
+        void newSearch();
+    };
+
+    // Plays a book or tablebase move if there is one, otherwise
+    // runs the search threads. The score is from white's point of view
+    pair<int, Move> searchPosition(const Board &board, Color turn);
+
+    // Searches all the moves of the root position to the given depth
+    // Returns the best move with its score for the side to move, and
+    // leaves its line in the first row of the thread's PV table
+    // The best MultiPV moves get exact scores and lines in the thread's
+    // root lines, the others are only proven worse than the last of them
+    // The search functions are templates of the side to move, so every
+    // color check inside them is folded away when they are compiled
+    template <Color Turn>
+    pair<int, Move> searchRoot(Board &board, int depth, int alpha, int beta, SearchData &data);
+
+    // Runs searchRoot from the first to the last depth, each depth
+    // in a narrow window around the score of the previous one
+    // Returns the result of the last completed depth
+    pair<int, Move> iterativeDeepening(Board &board, Color turn, int firstDepth, int lastDepth,
+                                       SearchData &data);
+
+    // Stops the search if the time or node budget has run out,
+    // or if it was asked to stop from another thread
+    void checkLimits();
+
+    // Passes the result of a completed depth to the info callback
+    void reportDepth(int depth, const pair<int, Move> &best) const;
+
+    // Alpha-beta search in negamax form
+    // Returns the score from the point of view of the side to move
+    // The moves are made and taken back on the given board
+    // allowNull is false right after a null move, so two never follow each other
+    // PV nodes store their best line in the triangular table of the thread
+    template <Color Turn, NodeType Node>
+    int alphaBeta(Board &board, int depth, int ply, int alpha, int beta, bool allowNull, SearchData &data);
+
+    // Searches only captures and queen promotions until the position
+    // is quiet, so the evaluation isn't taken in the middle of an
+    // exchange. The side to move may stand pat on the evaluation,
+    // captures that lose material are skipped, and a side in check
+    // searches all its moves instead
+    template <Color Turn>
+    int quiescence(Board &board, int ply, int alpha, int beta, SearchData &data);
+
+    // Gives every move an ordering score, the move of the previous line
+    // first, then the hash move, then captures by most valuable victim /
+    // least valuable attacker, then killer moves, then the rest by their history
+    template <Color Turn>
+    void scoreMoves(const Board &board, const Moves &moves, int scores[],
+                    int ply, Move hashMove, const SearchData &data) const;
+
+    // Moves the best scored move from index onwards to index
+    static void pickMove(Moves &moves, int scores[], int index);
+
+    // Makes a move of the search at the given ply, and sets up the
+    // accumulator of the next ply when there is a network
+    void playMove(Board &board, Move move, int ply, SearchData &data) const;
+
+    // Static evaluation of the position at the given ply of the search
+    // Returns the score from the point of view of the side to move
+    // Without a network, the pawn structure comes from the thread's pawn table
+    template <Color Turn>
+    int staticEvaluation(const Board &board, int ply, SearchData &data) const;
+
+    // Positions searched before, shared by all the threads
+    TranspositionTable table_;
+
+    // Data of every search thread, the first one is the main thread
+    vector<unique_ptr<SearchData>> threadData_;
+
+    // Tells the threads to stop searching
+    atomic<bool> stop_;
+
+    // Limits and start time of the running search
+    SearchLimits limits_;
+    chrono::steady_clock::time_point startTime_;
+
+    // Last depth the main thread completed
+    int completedDepth_;
+
+    // Start, length and completed depths of the last search, the
+    // start time above moves while the search is pondering
+    chrono::steady_clock::time_point searchStart_;
+    int64_t searchMilliseconds_ = 0;
+    vector<IterationStats> iterations_;
+
+    // Expected line of the last search, and the keys of the
+    // positions before each of its moves, so that the next
+    // search can start from the line if its position is on it
+    vector<Move> principalVariation_;
+    vector<uint64_t> lineKeys_;
+
+    // Lines of the best root moves of the last completed depth
+    vector<RootLine> rootLines_;
+
+    // Called after every completed depth, may be empty
+    function<void(const SearchInfo&)> infoCallback_;
+
+    // Opening book, probed before every search
+    const OpeningBook* book_ = nullptr;
+    BookSelection bookSelection_ = BOOK_WEIGHTED;
+    bool playedFromBook_ = false;
+
+    // Endgame tablebases, probed at every node with few pieces
+    const Tablebases* tablebases_ = nullptr;
+    bool playedFromTablebase_ = false;
+
+    // Evaluation network, the piece-square tables are used without one
+    const Network* network_ = nullptr;
+
+    PruningOptions pruning_;
+
+    // Size of the pawn table of every thread
+    size_t pawnHashKilobytes_ = DEFAULT_PAWN_HASH_KB;
 };
 
 
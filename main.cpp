@@ -6,7 +6,21 @@
 #include <iostream>
 #include "boardFunctions.h"
 #include "chessBot.h"
+#include "openingBook.h"
+#include "tablebases.h"
+#include "nnue.h"
+#include "batch.h"
+#include "match.h"
+#include "server.h"
+#include "bench.h"
+#include "perft.h"
+#include "uci.h"
+#include <atomic>
 #include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <omp.h>
 
 
 using namespace std;
@@ -33,8 +47,107 @@ vector<string> split(const string& str, const char delimiter) {
 }
 
 
+// Prints the result if the side to move has no legal move
+// Returns true if the game is over
+bool isGameFinished(const Board& board, const Color turn) {
+    const GameState state = getGameState(board, turn);
+    if (state == CHECKMATE) cout << (turn == WHITE ? "Black" : "White") << " won by checkmate!" << endl;
+    if (state == STALEMATE) cout << "Draw by stalemate!" << endl;
+    return state != ONGOING;
+}
+
+
+// Prints the best moves of a MultiPV search with their scores
+// for the side to move, in pawns or moves until mate, and lines
+void printRootLines(const vector<RootLine>& lines) {
+    if (lines.size() <= 1) return;
+    cout << "Best moves:" << endl;
+    for (size_t i = 0; i < lines.size(); i++) {
+        const int mate = movesToMate(lines[i].score);
+        ostringstream score;
+        if (mate != 0) score << "mate " << mate;
+        else score << showpos << fixed << setprecision(2) << lines[i].score / 10.0;
+        cout << "  " << i + 1 << ". " << score.str() << "  " << convertLineToNotation(lines[i].pv) << endl;
+    }
+}
+
+
+// Search the bot runs while the player is thinking. It searches the
+// position after the reply it expects, so that the reply can be answered
+// from the running search, or the player's position when it expects
+// none, so that the transposition table holds the results of every reply
+struct Ponder {
+    thread worker;
+    Board board;
+
+    // Reply the search assumes, NO_MOVE if it searches the player's position
+    Move expected = NO_MOVE;
+
+    atomic<bool> stop = false;
+    atomic<bool> done = false;
+    steady_clock::time_point start;
+    pair<int, Move> result;
+};
+
+// Starts pondering on the player's turn, after the bot played the
+// first move of its expected line. limits are the bot's limits
+void startPonder(Ponder& ponder, ChessBot& chessBot, const Board& board, const Color turn,
+                 const SearchLimits& limits) {
+    const vector<Move> line = chessBot.principalVariation();
+    ponder.board = board;
+    ponder.expected = line.size() >= 2 ? line[1] : NO_MOVE;
+    Color searched = turn;
+    if (ponder.expected != NO_MOVE) {
+        makeMove(ponder.board, ponder.expected);
+        searched = turn == WHITE ? BLACK : WHITE;
+    }
+
+    // The search runs until the player moves, or until the depth limit
+    SearchLimits ponderLimits;
+    ponderLimits.depth = limits.depth;
+    ponderLimits.multiPv = limits.multiPv;
+    ponderLimits.stop = &ponder.stop;
+    ponder.stop = false;
+    ponder.done = false;
+    ponder.start = steady_clock::now();
+    ponder.worker = thread([&ponder, &chessBot, searched, ponderLimits] {
+        ponder.result = chessBot.search(ponder.board, searched, ponderLimits);
+        ponder.done = true;
+    });
+}
+
+// Stops the search and waits for it, its results stay in the transposition table
+void stopPonder(Ponder& ponder) {
+    if (!ponder.worker.joinable()) return;
+    ponder.stop = true;
+    ponder.worker.join();
+}
+
+// The player played the expected reply, so the search goes on until the
+// thinking time has passed since it started, which may be right away
+pair<int, Move> ponderHit(Ponder& ponder, const int64_t milliseconds) {
+    const auto deadline = ponder.start + std::chrono::milliseconds(milliseconds);
+    while (!ponder.done && steady_clock::now() < deadline) this_thread::sleep_for(std::chrono::milliseconds(1));
+    stopPonder(ponder);
+    return ponder.result;
+}
+
+
 // Main loop of the game
-bool mainLoop() {
+// hashMegabytes is the size of the bots transposition table,
+// threads is the number of threads it searches with,
+// book is the opening book it plays from, if any,
+// tablebases are the endgame tables it probes, if any,
+// network is the network it evaluates with, if any, and
+// printStats prints the search statistics as JSON after every bot move,
+// pruning turns the parts of the selective search on or off,
+// ponder lets the bot search while the player is thinking,
+// pawnHashKilobytes is the size of the pawn hash table of every thread, and
+// multiPv is the number of best moves printed with their lines after every bot move
+bool mainLoop(const size_t hashMegabytes, const int threads, const OpeningBook* book,
+              const BookSelection bookSelection, const Tablebases* tablebases, const Network* network,
+              const bool printStats, const PruningOptions& pruning, const bool ponder,
+              const size_t pawnHashKilobytes, const int multiPv) {
     // Getting the users color
     cout << "What color would you like to play with (w/b, q for quit): ";
     string player_color;
@@ -47,20 +160,21 @@ bool mainLoop() {
     }
     Color turn = player_color == "w" ? WHITE : BLACK;
 
-    // Getting the bots depth
-    string bot_depth;
-    int depth;
-    cout << "Enter depth for the bot (an even integer recommended): ";
+    // Getting the bots thinking time
+    string bot_time;
+    SearchLimits limits;
+    limits.multiPv = multiPv;
+    cout << "Enter thinking time for the bot in milliseconds: ";
     while (true) {
-        getline(cin, bot_depth);
+        getline(cin, bot_time);
         try {
-            depth = stoi(bot_depth);
-        } catch (invalid_argument const& _) {
+            limits.milliseconds = stoll(bot_time);
+        } catch (exception const& _) {
             cout << "Please enter an integer: ";
             continue;
         }
-        if (depth <= 0) {
-            cout << "Please enter a non-negative integer: ";
+        if (limits.milliseconds <= 0) {
+            cout << "Please enter a positive integer: ";
             continue;
         }
         break;
@@ -68,78 +182,125 @@ bool mainLoop() {
 
     // Setting the board and bot
     Board board;
-    board.reserve(64);
     populateBoard(board);
 
-    ChessBot chessBot;
+    ChessBot chessBot(hashMegabytes);
+    chessBot.setThreads(threads);
+    chessBot.setBook(book, bookSelection);
+    chessBot.setTablebases(tablebases);
+    chessBot.setNetwork(network);
+    chessBot.setPruning(pruning);
+    chessBot.setPawnHashSize(pawnHashKilobytes);
 
     // Make the first move for black
     if (turn == BLACK) {
-        auto [_, move] = chessBot.minimax(board, depth, WHITE);
-        makeMove(board, move.first, move.second);
-        cout << "The bot started with " << convertIndexToNotation(move.first)
-        << " to " << convertIndexToNotation(move.second) << endl;
+        auto [_, move] = chessBot.search(board, WHITE, limits);
+        makeMove(board, move);
+        cout << "The bot started with " << convertIndexToNotation(move.start())
+        << " to " << convertIndexToNotation(move.end()) << endl;
+        cout << "Expected line: " << convertLineToNotation(chessBot.principalVariation()) << endl;
+        printRootLines(chessBot.rootLines());
+        if (printStats) cout << "Stats: " << chessBot.stats().toJson() << endl;
     }
 
     // The main game loop
     string input;
+    Ponder pondering;
     while (true) {
         printBoard(board);
 
         // If the game is over, break the loop
-        const Color gameStatus = isGameOver(board);
-        if (gameStatus != EMPTY) {
-            cout << (gameStatus == WHITE ? "White" : "Black")  << " won!" << endl;
-            break;
-        }
+        if (isGameFinished(board, turn)) break;
+
+        // It keeps running while the player enters invalid moves
+        if (ponder && !pondering.worker.joinable()) startPonder(pondering, chessBot, board, turn, limits);
 
         // Get the move from the player
         cout << "It's " << (turn == WHITE ? "white" : "black")  << "'s turn now." << endl;
         cout << "Enter the coordinates of your move (q for exit): ";
-        getline(cin, input);
-        if (input == "q" || input == "Q") {
+        if (!getline(cin, input) || input == "q" || input == "Q") {
+            stopPonder(pondering);
             return false;
         }
 
-        // Split the input into 2 coordinates
+        // Split the input into 2 coordinates, and
+        // optionally the piece to promote a pawn to
         auto player_move = split(input, ' ');
-        if (player_move.size() != 2) {
+        if (player_move.size() != 2 && player_move.size() != 3) {
             cout << "Please enter 2 valid coordinates" << endl;
             continue;
         }
         const int start = convertNotationToIndex(player_move[0]);
         const int end = convertNotationToIndex(player_move[1]);
 
+        PieceType promotion = QUEEN;
+        if (player_move.size() == 3) {
+            promotion = player_move[2].size() == 1 ? getPieceType(player_move[2][0]) : NO_PIECE;
+            if (promotion == PAWN || promotion == KING || promotion == NO_PIECE) {
+                cout << "Please promote to n, b, r or q" << endl;
+                continue;
+            }
+        }
+        const Move entered_move = createMove(board, start, end, promotion);
+
         // Check if the move is legal, make the move if it is
-        if (isLegalMove(board, start, end, turn)) {
-            makeMove(board, start, end);
+        if (entered_move != NO_MOVE && isLegalMove(board, entered_move, turn)) {
+            makeMove(board, entered_move);
             turn = turn == WHITE ? BLACK : WHITE;
         } else {
             cout << "Illegal move" << endl;
             continue;
         }
+        if (isGameFinished(board, turn)) {
+            stopPonder(pondering);
+            printBoard(board);
+            break;
+        }
 
         // The bots turn
         // Also counts the time in ms for how long the bot takes its time
         // and how many moves are analysed
+        // If the player made the expected reply, the search that has been
+        // running since the bot's last move goes on, otherwise it is stopped
+        // and a new one starts with the results it left in the table
         auto now = high_resolution_clock::now();
-        auto [_, move] = chessBot.minimax(board, depth, turn);
-        auto duration = duration_cast<milliseconds>(high_resolution_clock::now() - now);
-        cout << duration.count() << " ms to think" << endl;
-        cout << chessBot.movesMade() << " moves analysed" << endl;
-
-        // The bot couldn't find a move that's better than losing
-        // This implies checkmate
-        if (move == NO_MOVE) {
-            cout << "The bot forfeits!" << endl;
-            break;
+        const bool ponderHitMove = pondering.worker.joinable() && pondering.expected == entered_move;
+        pair<int, Move> result;
+        if (ponderHitMove) {
+            result = ponderHit(pondering, limits.milliseconds);
+        }
+        else {
+            stopPonder(pondering);
+            result = chessBot.search(board, turn, limits);
+        }
+        auto [_, move] = result;
+        auto duration = duration_cast<microseconds>(high_resolution_clock::now() - now);
+        if (ponderHitMove) cout << "Ponder hit, the bot expected this move" << endl;
+        if (chessBot.playedFromBook()) {
+            cout << "Book move found in " << duration.count() << " microseconds" << endl;
+        } else if (chessBot.playedFromTablebase()) {
+            cout << "Tablebase move found in " << duration.count() << " microseconds" << endl;
+        } else {
+            cout << duration.count() / 1000 << " ms to think" << endl;
+            cout << "Reached depth " << chessBot.completedDepth() << endl;
+            const SearchStats stats = chessBot.stats();
+            cout << stats.nodes << " moves analysed" << endl;
+            cout << "Hash table: " << static_cast<int>(stats.hash.hitRate() * 100) << "% hits, "
+            << static_cast<int>(stats.hash.missRate() * 100) << "% misses, "
+            << static_cast<int>(stats.hash.overwriteRate() * 100) << "% overwrites" << endl;
+            if (!network) cout << "Pawn hash table: " << static_cast<int>(stats.pawnHash.hitRate() * 100) << "% hits" << endl;
         }
+        if (printStats) cout << "Stats: " << chessBot.stats().toJson() << endl;
 
         // Print bots move and make the move
-        cout << "The bot played " << convertIndexToNotation(move.first)
-        << " to " << convertIndexToNotation(move.second) << endl;
+        cout << "The bot played " << convertIndexToNotation(move.start())
+        << " to " << convertIndexToNotation(move.end());
+        if (move.isPromotion()) cout << " promoting to " << "pnbrqk"[move.promotion()];
+        cout << endl;
+        cout << "Expected line: " << convertLineToNotation(chessBot.principalVariation()) << endl;
+        printRootLines(chessBot.rootLines());
 
-        makeMove(board, move.first, move.second);
+        makeMove(board, move);
         turn = turn == WHITE ? BLACK : WHITE;
 
         cout << endl << endl;
@@ -156,10 +317,375 @@ bool mainLoop() {
 }
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Command line options
+    // bench runs the search benchmark instead of a game
+    // perft counts the positions reachable from a position
+    // uci talks to a chess GUI with the UCI protocol
+    // batch searches the positions of a FEN or EPD file
+    // tbgen builds the endgame tablebases into the --tb directory
+    // match plays engine A against engine B, the options after --vs set B
+    // server hosts games for clients, client talks to it from the terminal,
+    // and loadgen plays many games on it at once to measure its latency
+    // --hash <MB> sets the transposition table size
+    // --pawn-hash <KB> sets the pawn hash table size of every search thread
+    // --threads <N> sets the number of search threads
+    // --depth <N> sets the benchmark, perft and batch depth
+    // --fen <FEN> sets the perft position
+    // --divide prints the perft count of every move
+    // --input <FILE> sets the batch positions, the standard input by default
+    // --movetime <MS> sets the batch thinking time of every position
+    // --csv writes the batch results as CSV instead of JSON lines
+    // --multipv <N> gives the N best moves of the game and batch searches a score and a line each
+    // --book <FILE> plays the opening from a Polyglot book
+    // --book-keys <FILE> reads the Polyglot Random64 numbers from a file instead of the built in ones
+    // --book-best plays the book move with the highest weight
+    // --tb <DIR> sets the directory of the endgame tablebases
+    // --pieces <N> sets the most pieces of the tablebases tbgen builds
+    // --nnue <FILE> evaluates with the network of the file instead of the piece-square tables
+    // --no-nnue evaluates with the piece-square tables, for engine B of a match
+    // --stats prints the statistics of every search of the game as JSON
+    // --no-ponder keeps the bot from searching while the player is thinking
+    // --no-null-move, --no-lmr and --no-futility turn off the parts of the selective search
+    // --games <N> sets the most games of a match
+    // --tc <MS+MS> sets the match time control, base and increment
+    // --openings <FILE> sets the FEN or EPD opening positions of a match
+    // --pgn <FILE> and --results <FILE> write the match games as PGN and JSON lines
+    // --sprt <ELO0,ELO1> sets the Elo bounds of the match test, --no-sprt plays every game
+    // --vs starts the options of engine B, which has the ones of A until changed
+    // --socket <PATH> and --port <N> set the address of the server, a Unix socket or a local TCP port
+    // --moves <N> sets the moves of every loadgen game
+    // --deadline <MS> sets the deadline of the server's searches, counted from their arrival
+    string mode = "play";
+    size_t hashMegabytes = DEFAULT_HASH_MB;
+    size_t pawnHashKilobytes = DEFAULT_PAWN_HASH_KB;
+    bool hashGiven = false;
+    int threads = omp_get_max_threads();
+    int depth = 6;
+    bool depthGiven = false;
+    string fen;
+    bool divide = false;
+    string input;
+    int64_t movetime = 0;
+    bool csv = false;
+    int multiPv = 1;
+    string bookPath;
+    string bookKeysPath;
+    BookSelection bookSelection = BOOK_WEIGHTED;
+    string tablebasePath;
+    int pieces = Tablebases::MAX_PIECES;
+    string networkPath;
+    bool printStats = false;
+    bool ponder = true;
+    PruningOptions pruning;
+    MatchOptions match;
+    bool timeControlGiven = false;
+    bool gamesGiven = false;
+    ServerAddress address;
+    int moves = 40;
+    int64_t deadline = 0;
+
+    // Engine A of a match, the settings given before --vs
+    bool versus = false;
+    int depthA = depth;
+    bool depthGivenA = false;
+    string networkPathA;
+    PruningOptions pruningA;
+    for (int i = 1; i < argc; i++) {
+        const string option = argv[i];
+        try {
+            if (i == 1 && (option == "bench" || option == "perft" || option == "uci" || option == "batch" ||
+                           option == "tbgen" || option == "match" || option == "server" || option == "client" ||
+                           option == "loadgen")) {
+                mode = option;
+            }
+            else if (option == "--hash" && i + 1 < argc) {
+                hashMegabytes = stoul(argv[++i]);
+                hashGiven = true;
+            }
+            else if (option == "--pawn-hash" && i + 1 < argc) {
+                pawnHashKilobytes = max(1UL, stoul(argv[++i]));
+            }
+            else if (option == "--threads" && i + 1 < argc) {
+                threads = max(1, stoi(argv[++i]));
+            }
+            else if (option == "--depth" && i + 1 < argc) {
+                depth = max(0, stoi(argv[++i]));
+                depthGiven = true;
+            }
+            else if (option == "--fen" && i + 1 < argc) {
+                fen = argv[++i];
+            }
+            else if (option == "--divide") {
+                divide = true;
+            }
+            else if (option == "--input" && i + 1 < argc) {
+                input = argv[++i];
+            }
+            else if (option == "--movetime" && i + 1 < argc) {
+                movetime = max(0LL, stoll(argv[++i]));
+            }
+            else if (option == "--multipv" && i + 1 < argc) {
+                multiPv = clamp(stoi(argv[++i]), 1, MAX_MOVES);
+            }
+            else if (option == "--csv") {
+                csv = true;
+            }
+            else if (option == "--book" && i + 1 < argc) {
+                bookPath = argv[++i];
+            }
+            else if (option == "--book-keys" && i + 1 < argc) {
+                bookKeysPath = argv[++i];
+            }
+            else if (option == "--book-best") {
+                bookSelection = BOOK_BEST;
+            }
+            else if (option == "--tb" && i + 1 < argc) {
+                tablebasePath = argv[++i];
+            }
+            else if (option == "--pieces" && i + 1 < argc) {
+                pieces = clamp(stoi(argv[++i]), 3, Tablebases::MAX_PIECES);
+            }
+            else if (option == "--nnue" && i + 1 < argc) {
+                networkPath = argv[++i];
+            }
+            else if (option == "--no-nnue") {
+                networkPath.clear();
+            }
+            else if (option == "--stats") {
+                printStats = true;
+            }
+            else if (option == "--no-ponder") {
+                ponder = false;
+            }
+            else if (option == "--no-null-move") {
+                pruning.nullMove = false;
+            }
+            else if (option == "--no-lmr") {
+                pruning.lateMoveReductions = false;
+            }
+            else if (option == "--no-futility") {
+                pruning.futility = false;
+            }
+            else if (option == "--games" && i + 1 < argc) {
+                match.games = max(1, stoi(argv[++i]));
+                gamesGiven = true;
+            }
+            else if (option == "--tc" && i + 1 < argc) {
+                const string timeControl = argv[++i];
+                const size_t plus = timeControl.find('+');
+                match.baseMilliseconds = max(1LL, stoll(timeControl.substr(0, plus)));
+                match.incrementMilliseconds = plus == string::npos ? 0 : max(0LL, stoll(timeControl.substr(plus + 1)));
+                timeControlGiven = true;
+            }
+            else if (option == "--openings" && i + 1 < argc) {
+                match.openings = argv[++i];
+            }
+            else if (option == "--pgn" && i + 1 < argc) {
+                match.pgn = argv[++i];
+            }
+            else if (option == "--results" && i + 1 < argc) {
+                match.results = argv[++i];
+            }
+            else if (option == "--sprt" && i + 1 < argc) {
+                const string bounds = argv[++i];
+                const size_t comma = bounds.find(',');
+                if (comma == string::npos) throw invalid_argument("bounds");
+                match.elo0 = stod(bounds.substr(0, comma));
+                match.elo1 = stod(bounds.substr(comma + 1));
+                if (match.elo1 <= match.elo0) throw invalid_argument("bounds");
+                match.sprt = true;
+            }
+            else if (option == "--no-sprt") {
+                match.sprt = false;
+            }
+            else if (option == "--socket" && i + 1 < argc) {
+                address.socketPath = argv[++i];
+            }
+            else if (option == "--port" && i + 1 < argc) {
+                address.port = clamp(stoi(argv[++i]), 1, 65535);
+            }
+            else if (option == "--moves" && i + 1 < argc) {
+                moves = max(1, stoi(argv[++i]));
+            }
+            else if (option == "--deadline" && i + 1 < argc) {
+                deadline = max(0LL, stoll(argv[++i]));
+            }
+            else if (option == "--vs" && !versus) {
+                versus = true;
+                depthA = depth;
+                depthGivenA = depthGiven;
+                networkPathA = networkPath;
+                pruningA = pruning;
+            }
+            else {
+                cout << "Usage: " << argv[0] << " [bench | perft | uci | batch | tbgen | match | server | client | loadgen]"
+                << " [--hash MB] [--pawn-hash KB] [--threads N]"
+                << " [--depth N] [--fen FEN] [--divide] [--input FILE] [--movetime MS] [--csv] [--multipv N]"
+                << " [--book FILE] [--book-keys FILE] [--book-best] [--tb DIR] [--pieces N]"
+                << " [--nnue FILE] [--no-nnue] [--stats] [--no-ponder] [--no-null-move] [--no-lmr] [--no-futility]"
+                << " [--games N] [--tc MS+MS] [--openings FILE] [--pgn FILE] [--results FILE]"
+                << " [--sprt ELO0,ELO1] [--no-sprt] [--vs OPTIONS] [--socket PATH | --port N] [--moves N]"
+                << " [--deadline MS]" << endl;
+                return 1;
+            }
+        } catch (exception const& _) {
+            cout << "Invalid value for " << option << ": " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    Network network;
+    if (!networkPath.empty()) {
+        string error;
+        if (!network.load(networkPath, error)) {
+            cout << "Invalid network: " << error << endl;
+            return 1;
+        }
+    }
+    const Network* networkUsed = network.isLoaded() ? &network : nullptr;
+
+    // The clients only talk to the server, they don't search
+    if (mode == "client" || mode == "loadgen") {
+        ClientOptions options;
+        options.address = address;
+        if (gamesGiven) options.games = match.games;
+        options.moves = moves;
+        options.milliseconds = movetime;
+        options.depth = depthGiven ? clamp(depth, 1, MAX_PLY - 1) : 0;
+        options.deadline = deadline;
+        if (mode == "client") return Client::run(options) ? 0 : 1;
+        return Client::loadTest(options) ? 0 : 1;
+    }
+
+    if (mode == "bench") {
+        Bench::run(max(1, depth), threads, hashMegabytes, networkUsed, pruning, pawnHashKilobytes);
+        return 0;
+    }
+
+    OpeningBook book;
+    if (!bookPath.empty()) {
+        string error;
+        if (!book.open(bookPath, bookKeysPath, error)) {
+            cout << "Invalid book: " << error << endl;
+            return 1;
+        }
+    }
+    const OpeningBook* bookUsed = book.isOpen() ? &book : nullptr;
+
+    Tablebases tablebases;
+    if (mode == "tbgen") {
+        if (tablebasePath.empty()) {
+            cout << "tbgen needs a --tb directory" << endl;
+            return 1;
+        }
+        return tablebases.generate(tablebasePath, pieces, threads) ? 0 : 1;
+    }
+    if (!tablebasePath.empty() && !tablebases.open(tablebasePath)) {
+        cout << "Cannot read the tablebases in " << tablebasePath << endl;
+        return 1;
+    }
+    const Tablebases* tablebasesUsed = tablebases.size() ? &tablebases : nullptr;
+
+    if (mode == "batch") {
+        // Every position gets a worker of its own, a thinking time
+        // without a depth searches as deep as the time allows
+        BatchOptions options;
+        options.input = input;
+        options.depth = depthGiven || movetime == 0 ? clamp(depth, 1, MAX_PLY - 1) : MAX_PLY - 1;
+        options.milliseconds = movetime;
+        options.workers = threads;
+        options.hashMegabytes = hashMegabytes;
+        options.pawnHashKilobytes = pawnHashKilobytes;
+        options.csv = csv;
+        options.multiPv = multiPv;
+        options.book = bookUsed;
+        options.bookSelection = bookSelection;
+        options.tablebases = tablebasesUsed;
+        options.network = networkUsed;
+        options.pruning = pruning;
+        return Batch::run(options) == 0 ? 0 : 1;
+    }
+
+    if (mode == "match") {
+        if (!versus) {
+            cout << "match needs the options of engine B after --vs" << endl;
+            return 1;
+        }
+
+        // Engine A only loads a network of its own if it uses another one than B
+        Network networkA;
+        if (!networkPathA.empty() && networkPathA != networkPath) {
+            string error;
+            if (!networkA.load(networkPathA, error)) {
+                cout << "Invalid network: " << error << endl;
+                return 1;
+            }
+        }
+
+        // Without a time control, the clock is turned off when every engine
+        // has a bound, a move time or a depth of its own. A depth given
+        // before --vs is kept by engine B unless it sets another one
+        match.engines[0].depth = depthGivenA ? clamp(depthA, 1, MAX_PLY - 1) : MAX_PLY - 1;
+        match.engines[0].network = networkPathA.empty() ? nullptr : networkPathA == networkPath ? networkUsed : &networkA;
+        match.engines[0].pruning = pruningA;
+        match.engines[1].depth = depthGiven ? clamp(depth, 1, MAX_PLY - 1) : MAX_PLY - 1;
+        match.engines[1].network = networkUsed;
+        match.engines[1].pruning = pruning;
+        if (!timeControlGiven && (movetime > 0 || (depthGivenA && depthGiven))) match.baseMilliseconds = 0;
+        match.moveMilliseconds = movetime;
+        match.workers = threads;
+        match.hashMegabytes = hashMegabytes;
+        match.pawnHashKilobytes = pawnHashKilobytes;
+        match.tablebases = tablebasesUsed;
+        return Match::run(match) ? 0 : 1;
+    }
+
+    if (mode == "server") {
+        // Every search of the server runs on one of --threads workers
+        ServerOptions options;
+        options.address = address;
+        options.workers = threads;
+        options.hashMegabytes = hashGiven ? hashMegabytes : SERVER_HASH_MB;
+        options.pawnHashKilobytes = pawnHashKilobytes;
+        options.depth = depthGiven ? clamp(depth, 1, MAX_PLY - 1) : MAX_PLY - 1;
+        if (movetime > 0 || depthGiven) options.milliseconds = movetime;
+        options.deadline = deadline;
+        options.tablebases = tablebasesUsed;
+        options.network = networkUsed;
+        options.pruning = pruning;
+        return Server::run(options) ? 0 : 1;
+    }
+
+    if (mode == "uci") {
+        Uci::run(hashMegabytes, threads, bookUsed, bookSelection, tablebasesUsed, networkUsed, pruning,
+                 pawnHashKilobytes);
+        return 0;
+    }
+
+    if (mode == "perft") {
+        Board board;
+        Color turn = WHITE;
+        populateBoard(board);
+        if (!fen.empty() && !loadFen(board, fen, turn)) {
+            cout << "Invalid FEN: " << fen << endl;
+            return 1;
+        }
+
+        // The table of counted subtrees is only used when asked for
+        PerftOptions options;
+        options.depth = depth;
+        options.divide = divide;
+        options.threads = threads;
+        options.hashMegabytes = hashGiven ? hashMegabytes : 0;
+        Perft::run(board, turn, options);
+        return 0;
+    }
+
     cout << "Welcome to Chess!" << endl << endl;
 
-    while (mainLoop()) {}
+    while (mainLoop(hashMegabytes, threads, bookUsed, bookSelection, tablebasesUsed, networkUsed, printStats,
+                    pruning, ponder, pawnHashKilobytes, multiPv)) {}
 
     return 0;
 }
\ No newline at end of file
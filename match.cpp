@@ -0,0 +1,398 @@
+/* Chess --- match.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "match.h"
+#include "chessBot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+
+using namespace BoardFunctions;
+using namespace std::chrono;
+
+const string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -";
+
+// Moves the time budget of a move is spread over, with the increment
+const int64_t MATCH_MOVES_TO_GO = 30;
+
+namespace {
+    // Result of a finished game, from white's point of view
+    enum GameResult {WHITE_WINS, BLACK_WINS, DRAW};
+
+    struct Game {
+        // Number of the game, from 1, and the engine playing white
+        int number;
+        int white;
+        string opening;
+
+        GameResult result;
+        string reason;
+        vector<string> moves;
+        Color firstTurn;
+    };
+
+    // Wins, draws and losses of engine B against engine A
+    struct Score {
+        int wins = 0;
+        int draws = 0;
+        int losses = 0;
+
+        int games() const { return wins + draws + losses; }
+        double ratio() const { return (wins + draws / 2.0) / max(games(), 1); }
+
+        // Variance of the result of a single game
+        double variance() const {
+            const double score = ratio();
+            return (wins * pow(1 - score, 2) + draws * pow(0.5 - score, 2) + losses * pow(score, 2)) /
+                   max(games(), 1);
+        }
+    };
+
+    // Elo difference of a score ratio
+    double elo(const double ratio) {
+        const double clamped = clamp(ratio, 1e-6, 1 - 1e-6);
+        return -400 * log10(1 / clamped - 1);
+    }
+
+    // Score ratio of an Elo difference
+    double expectedScore(const double elo) {
+        return 1 / (1 + pow(10, -elo / 400));
+    }
+
+    // Log likelihood ratio of elo1 against elo0, with the games
+    // approximated by a normal distribution of their results
+    double logLikelihoodRatio(const Score& score, const double elo0, const double elo1) {
+        if (score.games() == 0) return 0;
+
+        // Half a game of every result keeps the variance above zero
+        // when all the games so far ended the same way
+        const double wins = score.wins + 0.5, draws = score.draws + 0.5, losses = score.losses + 0.5;
+        const double games = wins + draws + losses;
+        const double ratio = (wins + draws / 2) / games;
+        const double variance = (wins * pow(1 - ratio, 2) + draws * pow(0.5 - ratio, 2) + losses * pow(ratio, 2)) / games;
+
+        const double score0 = expectedScore(elo0);
+        const double score1 = expectedScore(elo1);
+        return score.games() * (score1 - score0) * (2 * ratio - score0 - score1) / (2 * variance);
+    }
+
+    // Name of an engine in the results, with what sets it apart
+    string engineName(const MatchEngine& engine, const int index) {
+        string name = index == 0 ? "A" : "B";
+        vector<string> details;
+        if (engine.depth < MAX_PLY - 1) details.push_back("depth " + to_string(engine.depth));
+        if (engine.network) details.push_back("nnue");
+        if (!engine.pruning.nullMove) details.push_back("no null move");
+        if (!engine.pruning.lateMoveReductions) details.push_back("no lmr");
+        if (!engine.pruning.futility) details.push_back("no futility");
+        for (size_t i = 0; i < details.size(); i++) name += (i ? ", " : " (") + details[i];
+        return details.empty() ? name : name + ")";
+    }
+
+    // Reads the opening positions, skipping empty lines and # comments
+    // Only the position fields of FEN and EPD lines are kept
+    bool readOpenings(const string& path, vector<string>& openings) {
+        ifstream file(path);
+        if (!file) return false;
+
+        string line;
+        while (getline(file, line)) {
+            if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == string::npos) continue;
+            istringstream stream(line);
+            string field, fen;
+            for (int i = 0; i < 4 && stream >> field; i++) fen += (i ? " " : "") + field;
+
+            Board board;
+            Color turn;
+            if (!loadFen(board, fen, turn)) {
+                cerr << "Skipping invalid opening: " << line << endl;
+                continue;
+            }
+            openings.push_back(fen);
+        }
+        return true;
+    }
+
+    // Neither side can mate: bare kings, or a single minor piece
+    bool isInsufficientMaterial(const Board& board) {
+        Bitboard minors = 0;
+        for (const Color color : {WHITE, BLACK}) {
+            if (board.pieces[color][PAWN] | board.pieces[color][ROOK] | board.pieces[color][QUEEN]) return false;
+            minors |= board.pieces[color][KNIGHT] | board.pieces[color][BISHOP];
+        }
+        return Bitboards::popCount(minors) <= 1;
+    }
+
+    // Plays a game between the bots, bots[0] is engine A and bots[1] engine B
+    // Returns false if the match was stopped before the game ended
+    bool playGame(Game& game, ChessBot* bots[2], const MatchOptions& options, atomic<bool>& stop) {
+        Board board;
+        Color turn;
+        loadFen(board, game.opening, turn);
+        game.firstTurn = turn;
+        for (int i = 0; i < 2; i++) bots[i]->clearHash();
+
+        int64_t clock[2] = {options.baseMilliseconds, options.baseMilliseconds};
+
+        // Keys of the positions since the last capture or pawn move,
+        // only those can repeat, so this is also the fifty-move count
+        vector<uint64_t> keys = {getHashKey(board, turn)};
+
+        while (true) {
+            const Color opponent = turn == WHITE ? BLACK : WHITE;
+            const GameResult loss = turn == WHITE ? BLACK_WINS : WHITE_WINS;
+
+            const GameState state = getGameState(board, turn);
+            if (state == CHECKMATE) {
+                game.result = loss;
+                game.reason = (opponent == WHITE ? "White" : "Black") + string(" mates");
+                return true;
+            }
+            if (state == STALEMATE) {
+                game.result = DRAW;
+                game.reason = "stalemate";
+                return true;
+            }
+            if (count(keys.begin(), keys.end(), keys.back()) >= 3) {
+                game.result = DRAW;
+                game.reason = "threefold repetition";
+                return true;
+            }
+            if (keys.size() > 100) {
+                game.result = DRAW;
+                game.reason = "fifty-move rule";
+                return true;
+            }
+            if (isInsufficientMaterial(board)) {
+                game.result = DRAW;
+                game.reason = "insufficient material";
+                return true;
+            }
+
+            const int engine = turn == WHITE ? game.white : 1 - game.white;
+            SearchLimits limits;
+            limits.depth = options.engines[engine].depth;
+            limits.stop = &stop;
+            if (options.baseMilliseconds > 0) {
+                const int64_t budget = clock[turn] / MATCH_MOVES_TO_GO + options.incrementMilliseconds * 3 / 4;
+                limits.milliseconds = max<int64_t>(1, min(budget, clock[turn] / 2));
+            }
+            else {
+                limits.milliseconds = options.moveMilliseconds;
+            }
+
+            const auto start = steady_clock::now();
+            const Move move = bots[engine]->search(board, turn, limits).second;
+            const int64_t elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+            if (stop.load(memory_order_relaxed)) return false;
+
+            if (options.baseMilliseconds > 0) {
+                clock[turn] -= elapsed;
+                if (clock[turn] < 0) {
+                    game.result = loss;
+                    game.reason = (turn == WHITE ? "White" : "Black") + string(" loses on time");
+                    return true;
+                }
+                clock[turn] += options.incrementMilliseconds;
+            }
+
+            const bool irreversible = getPieceType(board[move.start()]) == PAWN || board[move.end()] != '0';
+            game.moves.push_back(convertMoveToSan(board, move, turn));
+            makeMove(board, move);
+            turn = opponent;
+            if (irreversible) keys.clear();
+            keys.push_back(getHashKey(board, turn));
+        }
+    }
+
+    string resultNotation(const GameResult result) {
+        return result == WHITE_WINS ? "1-0" : result == BLACK_WINS ? "0-1" : "1/2-1/2";
+    }
+
+    string formatPgn(const Game& game, const MatchOptions& options, const string names[2], const string& date) {
+        ostringstream pgn;
+        pgn << "[Event \"Chess match\"]\n[Site \"local\"]\n[Date \"" << date << "\"]\n"
+            << "[Round \"" << game.number << "\"]\n"
+            << "[White \"" << names[game.white] << "\"]\n[Black \"" << names[1 - game.white] << "\"]\n"
+            << "[Result \"" << resultNotation(game.result) << "\"]\n";
+        if (game.opening != START_FEN) pgn << "[SetUp \"1\"]\n[FEN \"" << game.opening << " 0 1\"]\n";
+        if (options.baseMilliseconds > 0) {
+            pgn << "[TimeControl \"" << options.baseMilliseconds / 1000.0 << "+"
+                << options.incrementMilliseconds / 1000.0 << "\"]\n";
+        }
+        pgn << "[Termination \"" << (game.reason.ends_with("on time") ? "time forfeit" : "normal") << "\"]\n\n";
+
+        // Move text, with lines kept under 80 characters
+        string text;
+        size_t lineLength = 0;
+        auto add = [&](const string& token) {
+            if (lineLength && lineLength + token.size() + 1 > 79) {
+                text += "\n";
+                lineLength = 0;
+            }
+            else if (lineLength) {
+                text += " ";
+                lineLength++;
+            }
+            text += token;
+            lineLength += token.size();
+        };
+        const int offset = game.firstTurn == WHITE ? 0 : 1;
+        for (size_t i = 0; i < game.moves.size(); i++) {
+            const size_t ply = i + offset;
+            if (ply % 2 == 0) add(to_string(ply / 2 + 1) + ".");
+            else if (i == 0) add(to_string(ply / 2 + 1) + "...");
+            add(game.moves[i]);
+        }
+        add("{" + game.reason + "}");
+        add(resultNotation(game.result));
+        pgn << text << "\n\n";
+        return pgn.str();
+    }
+
+    string formatResult(const Game& game, const string names[2]) {
+        ostringstream line;
+        line << "{\"game\":" << game.number << ",\"opening\":\"" << game.opening << "\",\"white\":\""
+             << names[game.white] << "\",\"black\":\"" << names[1 - game.white] << "\",\"result\":\""
+             << resultNotation(game.result) << "\",\"reason\":\"" << game.reason << "\",\"plies\":"
+             << game.moves.size() << "}";
+        return line.str();
+    }
+}
+
+namespace Match {
+    bool run(const MatchOptions& options) {
+        vector<string> openings;
+        if (!options.openings.empty()) {
+            if (!readOpenings(options.openings, openings)) {
+                cerr << "Cannot open " << options.openings << endl;
+                return false;
+            }
+            if (openings.empty()) {
+                cerr << "No valid openings in " << options.openings << endl;
+                return false;
+            }
+        }
+        if (openings.empty()) openings.push_back(START_FEN);
+
+        ofstream pgn, results;
+        if (!options.pgn.empty()) {
+            pgn.open(options.pgn);
+            if (!pgn) {
+                cerr << "Cannot write " << options.pgn << endl;
+                return false;
+            }
+        }
+        if (!options.results.empty()) {
+            results.open(options.results);
+            if (!results) {
+                cerr << "Cannot write " << options.results << endl;
+                return false;
+            }
+        }
+
+        const string names[2] = {engineName(options.engines[0], 0), engineName(options.engines[1], 1)};
+        const int games = (max(options.games, 1) + 1) / 2 * 2;
+        const double lowerBound = log(options.beta / (1 - options.alpha));
+        const double upperBound = log((1 - options.beta) / options.alpha);
+
+        const time_t now = time(nullptr);
+        char date[16];
+        strftime(date, sizeof(date), "%Y.%m.%d", localtime(&now));
+
+        cout << names[0] << " vs " << names[1] << ", " << games << " games, " << openings.size()
+             << " openings, " << options.workers << " at a time";
+        if (options.baseMilliseconds > 0) {
+            cout << ", " << options.baseMilliseconds << "+" << options.incrementMilliseconds << " ms";
+        }
+        else if (options.moveMilliseconds > 0) {
+            cout << ", " << options.moveMilliseconds << " ms per move";
+        }
+        cout << endl;
+        if (options.sprt) {
+            cout << "SPRT elo0 " << options.elo0 << ", elo1 " << options.elo1 << ", alpha " << options.alpha
+                 << ", beta " << options.beta << ", bounds " << fixed << setprecision(2) << lowerBound
+                 << " " << upperBound << endl;
+        }
+        cout << endl;
+
+        Score score;
+        int nextGame = 0;
+        string decision;
+        atomic<bool> stop = false;
+        const auto start = steady_clock::now();
+
+        // Every worker plays whole games with a bot for each engine, and
+        // takes the next game when it is done. The openings are played
+        // in pairs, so both engines get each of them with both colors
+        #pragma omp parallel num_threads(options.workers) default(none) \
+            shared(options, openings, names, games, lowerBound, upperBound, date, score, nextGame, decision, \
+                   stop, pgn, results, cout)
+        {
+            ChessBot bots[2] = {ChessBot(options.hashMegabytes), ChessBot(options.hashMegabytes)};
+            ChessBot* players[2] = {&bots[0], &bots[1]};
+            for (int i = 0; i < 2; i++) {
+                bots[i].setThreads(1);
+                bots[i].setNetwork(options.engines[i].network);
+                bots[i].setPruning(options.engines[i].pruning);
+                bots[i].setTablebases(options.tablebases);
+                bots[i].setPawnHashSize(options.pawnHashKilobytes);
+            }
+
+            while (!stop.load(memory_order_relaxed)) {
+                Game game;
+                #pragma omp critical(matchSchedule)
+                game.number = nextGame < games ? ++nextGame : 0;
+                if (game.number == 0) break;
+
+                game.white = (game.number - 1) % 2;
+                game.opening = openings[(game.number - 1) / 2 % openings.size()];
+                if (!playGame(game, players, options, stop)) break;
+
+                #pragma omp critical(matchResults)
+                {
+                    // The score is B's, so a win of A is a loss
+                    if (game.result == DRAW) score.draws++;
+                    else if ((game.result == WHITE_WINS) == (game.white == 1)) score.wins++;
+                    else score.losses++;
+
+                    if (pgn.is_open()) pgn << formatPgn(game, options, names, date) << flush;
+                    if (results.is_open()) results << formatResult(game, names) << endl;
+
+                    const double ratio = score.ratio();
+                    const double margin = 1.96 * sqrt(score.variance() / score.games());
+                    cout << "Game " << setw(4) << game.number << ": " << names[game.white] << " - "
+                         << names[1 - game.white] << " " << resultNotation(game.result) << " (" << game.reason
+                         << ")" << endl;
+                    cout << "B: " << score.wins << " wins, " << score.draws << " draws, " << score.losses
+                         << " losses, Elo " << fixed << setprecision(1) << elo(ratio) << " [" << elo(ratio - margin)
+                         << ", " << elo(ratio + margin) << "]";
+                    if (options.sprt) {
+                        const double llr = logLikelihoodRatio(score, options.elo0, options.elo1);
+                        cout << ", LLR " << setprecision(2) << llr;
+                        if (decision.empty() && llr >= upperBound) decision = "H1 accepted: B is stronger";
+                        if (decision.empty() && llr <= lowerBound) decision = "H0 accepted: B is not stronger";
+                        if (!decision.empty()) stop = true;
+                    }
+                    cout << endl;
+                }
+            }
+        }
+
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+        cout << endl << "Finished " << score.games() << " games in " << fixed << setprecision(1) << seconds
+             << " s, B scored " << setprecision(1) << score.ratio() * 100 << "%" << endl;
+        if (options.sprt) cout << "SPRT: " << (decision.empty() ? "no decision" : decision) << endl;
+        return true;
+    }
+}
@@ -0,0 +1,89 @@
+/* Chess --- match.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_MATCH_H
+#define CHESS_MATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "chessBot.h"
+#include "nnue.h"
+#include "tablebases.h"
+
+using namespace std;
+
+// Settings of one of the two engines of a match
+struct MatchEngine {
+    // Depth limit of every move, the clock decides without one
+    int depth = MAX_PLY - 1;
+
+    // Network it evaluates with, the piece-square tables if none
+    const Network* network = nullptr;
+
+    // Parts of the selective search it uses
+    PruningOptions pruning;
+};
+
+// Options of a match between two engine configurations
+struct MatchOptions {
+    // The first engine is A, the one being tested is B
+    MatchEngine engines[2];
+
+    // Most games played, every opening is played twice
+    // with the colors swapped, so this is rounded up to even
+    int games = 100;
+
+    // Games played at the same time, every engine searches with one thread
+    int workers = 1;
+
+    // Transposition table size of every engine
+    size_t hashMegabytes = 16;
+
+    // Pawn hash table size of every engine
+    size_t pawnHashKilobytes = DEFAULT_PAWN_HASH_KB;
+
+    // Time control, the clock of each side starts with base and gets the
+    // increment after every move. Without a base, every move gets
+    // moveMilliseconds, or only the depth limit if that is zero as well
+    int64_t baseMilliseconds = 10000;
+    int64_t incrementMilliseconds = 100;
+    int64_t moveMilliseconds = 0;
+
+    // File of FEN or EPD opening positions, one per line,
+    // the games start from the starting position when empty
+    string openings;
+
+    // Files the games are written to in PGN, and the results as JSON
+    // lines, one per game, nothing is written when they are empty
+    string pgn;
+    string results;
+
+    // Sequential probability ratio test: the match stops as soon as the
+    // games tell that B is elo1 rather than elo0 stronger than A (or the
+    // other way round), wrongly accepting elo1 at most alpha of the time
+    // and wrongly accepting elo0 at most beta. Off, all the games are played
+    bool sprt = true;
+    double elo0 = 0;
+    double elo1 = 10;
+    double alpha = 0.05;
+    double beta = 0.05;
+
+    // Endgame tablebases both engines probe, if any
+    const Tablebases* tablebases = nullptr;
+};
+
+// Namespace that holds the self-play match runner
+namespace Match {
+    // Plays the games of the match, every one in the same process, and
+    // prints the score, Elo difference and test of B against A after every
+    // game. Games end in checkmate, stalemate, threefold repetition, the
+    // fifty-move rule, insufficient material or a flag fall
+    // Returns false if the openings or the output files can't be opened
+    bool run(const MatchOptions& options);
+}
+
+
+#endif //CHESS_MATCH_H
@@ -0,0 +1,265 @@
+/* Chess --- nnue.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "nnue.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace BoardFunctions;
+using namespace Bitboards;
+
+namespace {
+    // A network file is the magic, the number of inputs and of first layer
+    // neurons as 32 bit integers, then the weights, all little endian:
+    // the first layer weights as int16, input by input, its biases as
+    // int16, the output weights as int8, the side to move's neurons first,
+    // and the output bias as int32
+    const char MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'N', 'N', '1'};
+    const size_t FILE_SIZE = sizeof(MAGIC) + 2 * 4 + NNUE_INPUTS * NNUE_HIDDEN * 2 +
+                             NNUE_HIDDEN * 2 + 2 * NNUE_HIDDEN + 4;
+
+    // Activations are clipped to 0..ACTIVATION_MAX, which stands for 1.0
+    const int ACTIVATION_MAX = 127;
+
+    // An output weight of OUTPUT_QUANT stands for 1.0
+    const int OUTPUT_QUANT = 64;
+
+    // The network is trained on centipawns divided by this, and a pawn
+    // is 100 centipawns but 10 in the hand-written evaluation
+    const int OUTPUT_SCALE = 400;
+    const int CENTIPAWNS_PER_UNIT = 10;
+
+    // Input of a piece from the point of view of one side, which sees
+    // its own pieces as the first color and the board from its side
+    int featureIndex(const Color perspective, Color color, const PieceType type, int square) {
+        if (perspective == BLACK) {
+            color = color == WHITE ? BLACK : WHITE;
+            square ^= 56;
+        }
+        return (color * 6 + type) * 64 + square;
+    }
+
+    // Reads a little endian integer of the given size
+    int64_t readInteger(const unsigned char*& data, const int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        data += bytes;
+
+        // Sign extended from the top bit of its size
+        const int unused = 64 - 8 * bytes;
+        return static_cast<int64_t>(value << unused) >> unused;
+    }
+
+    // Sets output to input plus the added rows minus the removed rows,
+    // output may be input. Used for one perspective of an accumulator
+    void applyRows(const int16_t* input, int16_t* output, const int16_t* const added[], const int addedCount,
+                   const int16_t* const removed[], const int removedCount) {
+#if defined(CHESS_USE_AVX2)
+        for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+            __m256i sum = _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i));
+            for (int j = 0; j < addedCount; j++) {
+                sum = _mm256_add_epi16(sum, _mm256_load_si256(reinterpret_cast<const __m256i*>(added[j] + i)));
+            }
+            for (int j = 0; j < removedCount; j++) {
+                sum = _mm256_sub_epi16(sum, _mm256_load_si256(reinterpret_cast<const __m256i*>(removed[j] + i)));
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(output + i), sum);
+        }
+#elif defined(CHESS_USE_SSSE3)
+        for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+            __m128i sum = _mm_load_si128(reinterpret_cast<const __m128i*>(input + i));
+            for (int j = 0; j < addedCount; j++) {
+                sum = _mm_add_epi16(sum, _mm_load_si128(reinterpret_cast<const __m128i*>(added[j] + i)));
+            }
+            for (int j = 0; j < removedCount; j++) {
+                sum = _mm_sub_epi16(sum, _mm_load_si128(reinterpret_cast<const __m128i*>(removed[j] + i)));
+            }
+            _mm_store_si128(reinterpret_cast<__m128i*>(output + i), sum);
+        }
+#else
+        for (int i = 0; i < NNUE_HIDDEN; i++) {
+            int16_t sum = input[i];
+            for (int j = 0; j < addedCount; j++) sum = static_cast<int16_t>(sum + added[j][i]);
+            for (int j = 0; j < removedCount; j++) sum = static_cast<int16_t>(sum - removed[j][i]);
+            output[i] = sum;
+        }
+#endif
+    }
+
+    // Dot product of the clipped neurons with the int8 weights of the output layer
+    int32_t outputSum(const int16_t* neurons, const int8_t* weights) {
+#if defined(CHESS_USE_AVX2)
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i top = _mm256_set1_epi16(ACTIVATION_MAX);
+        const __m256i ones = _mm256_set1_epi16(1);
+        __m256i sum = zero;
+        for (int i = 0; i < NNUE_HIDDEN; i += 32) {
+            const __m256i low = _mm256_min_epi16(_mm256_max_epi16(
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(neurons + i)), zero), top);
+            const __m256i high = _mm256_min_epi16(_mm256_max_epi16(
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(neurons + i + 16)), zero), top);
+
+            // Packing works within 128 bit lanes, the permute puts the bytes back in order
+            const __m256i clipped = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+
+            // Pairs of products fit in int16, since 2 * 127 * 127 < 32768
+            const __m256i products = _mm256_maddubs_epi16(
+                clipped, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+        }
+        const __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        const __m128i quarter = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        return _mm_cvtsi128_si32(_mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, 0xB1)));
+#elif defined(CHESS_USE_SSSE3)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i top = _mm_set1_epi16(ACTIVATION_MAX);
+        const __m128i ones = _mm_set1_epi16(1);
+        __m128i sum = zero;
+        for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+            const __m128i low = _mm_min_epi16(_mm_max_epi16(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(neurons + i)), zero), top);
+            const __m128i high = _mm_min_epi16(_mm_max_epi16(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(neurons + i + 8)), zero), top);
+            const __m128i products = _mm_maddubs_epi16(
+                _mm_packus_epi16(low, high), _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+        }
+        const __m128i half = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        return _mm_cvtsi128_si32(_mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1)));
+#else
+        int32_t sum = 0;
+        for (int i = 0; i < NNUE_HIDDEN; i++) {
+            sum += clamp<int32_t>(neurons[i], 0, ACTIVATION_MAX) * weights[i];
+        }
+        return sum;
+#endif
+    }
+}
+
+struct alignas(64) Network::Weights {
+    int16_t features[NNUE_INPUTS][NNUE_HIDDEN];
+    int16_t biases[NNUE_HIDDEN];
+    int8_t output[2 * NNUE_HIDDEN];
+    int32_t outputBias;
+};
+
+Network::Network() = default;
+
+Network::~Network() = default;
+
+bool Network::load(const string& path, string& error) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    const vector<unsigned char> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    if (bytes.size() < sizeof(MAGIC) || !equal(MAGIC, MAGIC + sizeof(MAGIC), bytes.begin())) {
+        error = path + " is not a network file";
+        return false;
+    }
+
+    const unsigned char* data = bytes.data() + sizeof(MAGIC);
+    if (bytes.size() < sizeof(MAGIC) + 8 || readInteger(data, 4) != NNUE_INPUTS ||
+        readInteger(data, 4) != NNUE_HIDDEN) {
+        error = "the network has to have " + to_string(NNUE_INPUTS) + " inputs and " +
+                to_string(NNUE_HIDDEN) + " neurons";
+        return false;
+    }
+    if (bytes.size() != FILE_SIZE) {
+        error = path + " has " + to_string(bytes.size()) + " bytes instead of " + to_string(FILE_SIZE);
+        return false;
+    }
+
+    auto weights = make_unique<Weights>();
+    for (auto& input : weights->features) {
+        for (int16_t& weight : input) weight = static_cast<int16_t>(readInteger(data, 2));
+    }
+    for (int16_t& bias : weights->biases) bias = static_cast<int16_t>(readInteger(data, 2));
+    for (int8_t& weight : weights->output) weight = static_cast<int8_t>(readInteger(data, 1));
+    weights->outputBias = static_cast<int32_t>(readInteger(data, 4));
+
+    weights_ = std::move(weights);
+    return true;
+}
+
+bool Network::isLoaded() const {
+    return weights_ != nullptr;
+}
+
+void Network::refresh(const Board& board, Accumulator& accumulator) const {
+    for (const Color perspective : {WHITE, BLACK}) {
+        int16_t* values = accumulator.values[perspective];
+        copy(begin(weights_->biases), end(weights_->biases), values);
+
+        for (const Color color : {WHITE, BLACK}) {
+            for (int type = PAWN; type <= KING; type++) {
+                Bitboard pieces = board.pieces[color][type];
+                while (pieces) {
+                    const int16_t* row = weights_->features[featureIndex(
+                        perspective, color, static_cast<PieceType>(type), popLsb(pieces))];
+                    applyRows(values, values, &row, 1, nullptr, 0);
+                }
+            }
+        }
+    }
+}
+
+void Network::update(const Board& board, const Move move, const UndoInfo& undo,
+                     const Accumulator& parent, Accumulator& child) const {
+    const int start = move.start();
+    const int end = move.end();
+    const Color color = getColor(board[end]);
+
+    // A move adds and removes at most two pieces, castling
+    // moves the rook too and a capture removes the victim
+    Color addedColors[2] = {color, color};
+    PieceType addedTypes[2] = {getPieceType(board[end]), ROOK};
+    int addedSquares[2] = {end, NO_SQUARE};
+    Color removedColors[2] = {color, color};
+    PieceType removedTypes[2] = {move.isPromotion() ? PAWN : getPieceType(board[end]), ROOK};
+    int removedSquares[2] = {start, NO_SQUARE};
+    int addedCount = 1;
+    int removedCount = 1;
+
+    if (move.flag() == CASTLING) {
+        addedSquares[addedCount++] = end > start ? start + 1 : start - 1;
+        removedSquares[removedCount++] = end > start ? start + 3 : start - 4;
+    }
+    else if (undo.captured != '0') {
+        removedColors[removedCount] = getColor(undo.captured);
+        removedTypes[removedCount] = getPieceType(undo.captured);
+        removedSquares[removedCount++] = move.flag() == EN_PASSANT ? end - (color == WHITE ? 8 : -8) : end;
+    }
+
+    for (const Color perspective : {WHITE, BLACK}) {
+        const int16_t* added[2];
+        const int16_t* removed[2];
+        for (int i = 0; i < addedCount; i++) {
+            added[i] = weights_->features[featureIndex(perspective, addedColors[i], addedTypes[i], addedSquares[i])];
+        }
+        for (int i = 0; i < removedCount; i++) {
+            removed[i] = weights_->features[featureIndex(perspective, removedColors[i], removedTypes[i],
+                                                         removedSquares[i])];
+        }
+        applyRows(parent.values[perspective], child.values[perspective], added, addedCount, removed, removedCount);
+    }
+}
+
+int Network::evaluate(const Accumulator& accumulator, const Color turn) const {
+    const Color opponent = turn == WHITE ? BLACK : WHITE;
+    const int64_t sum = static_cast<int64_t>(weights_->outputBias) +
+                        outputSum(accumulator.values[turn], weights_->output) +
+                        outputSum(accumulator.values[opponent], weights_->output + NNUE_HIDDEN);
+    return static_cast<int>(sum * OUTPUT_SCALE / (ACTIVATION_MAX * OUTPUT_QUANT * CENTIPAWNS_PER_UNIT));
+}
+
+int Network::evaluate(const Board& board, const Color turn) const {
+    Accumulator accumulator;
+    refresh(board, accumulator);
+    return evaluate(accumulator, turn);
+}
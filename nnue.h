@@ -0,0 +1,79 @@
+/* Chess --- nnue.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_NNUE_H
+#define CHESS_NNUE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "boardFunctions.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CHESS_USE_AVX2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define CHESS_USE_SSSE3
+#endif
+
+using namespace std;
+
+// Inputs of the network, one for every color, piece type and square
+const int NNUE_INPUTS = 2 * 6 * 64;
+
+// Neurons of the first layer, for each of the two perspectives
+const int NNUE_HIDDEN = 256;
+
+// First layer outputs of a position, once from white's and once from
+// black's point of view. They only change by a few weight rows per move,
+// so the search updates them from the position before the move.
+struct alignas(64) Accumulator {
+    int16_t values[2][NNUE_HIDDEN];
+};
+
+// Efficiently updatable neural network evaluation. The first layer turns
+// the pieces of the board into an accumulator for each side, the side to
+// move's first. Both are clipped to 0..127 and go through the output
+// layer, which gives the score. The weights are quantized, int16 in the
+// first layer and int8 in the output layer, and the layers run as AVX2
+// or SSSE3 kernels when the CPU has them, with a scalar fallback.
+// Evaluating only reads the weights, so the threads can share a network.
+class Network {
+public:
+    Network();
+    ~Network();
+
+    Network(const Network&) = delete;
+    Network& operator=(const Network&) = delete;
+
+    // Reads the weights of a network file, see the source for the format
+    // Returns false with the reason in error if the file can't be used
+    bool load(const string& path, string& error);
+
+    bool isLoaded() const;
+
+    // Sets the accumulator up from all the pieces of the board
+    void refresh(const Board& board, Accumulator& accumulator) const;
+
+    // Sets child to the accumulator after the move from the accumulator
+    // before it, the board is the position after the move was made
+    void update(const Board& board, Move move, const UndoInfo& undo,
+                const Accumulator& parent, Accumulator& child) const;
+
+    // Returns the score of the accumulator for the side to move,
+    // in the units of the hand-written evaluation
+    int evaluate(const Accumulator& accumulator, Color turn) const;
+
+    // Evaluates the board from scratch, for the side to move
+    int evaluate(const Board& board, Color turn) const;
+private:
+    struct Weights;
+
+    unique_ptr<Weights> weights_;
+};
+
+
+#endif //CHESS_NNUE_H
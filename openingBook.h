@@ -0,0 +1,79 @@
+/* Chess --- openingBook.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_OPENINGBOOK_H
+#define CHESS_OPENINGBOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "boardFunctions.h"
+
+using namespace std;
+
+// How a move is chosen when the book has more than one
+enum BookSelection {BOOK_WEIGHTED, BOOK_BEST};
+
+// Polyglot opening book, a .bin file of 16 byte entries sorted by the
+// Polyglot hash key of their position. The file is memory mapped and
+// searched in place, so opening it doesn't read it and probing takes
+// a binary search. Probing only reads the file, so the threads can
+// share a book.
+//
+// Polyglot keys are built from the 781 Random64 numbers published with
+// the format. The numbers are built in, or read from a text file that
+// contains them in order, and are checked against known keys when the
+// book is opened.
+class OpeningBook {
+public:
+    OpeningBook() = default;
+    ~OpeningBook();
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // Maps the book and reads the Random64 numbers from keysPath,
+    // or uses the built in ones if keysPath is empty
+    // Returns false with the reason in error if either fails
+    bool open(const string& bookPath, const string& keysPath, string& error);
+
+    // Unmaps the book
+    void close();
+
+    bool isOpen() const;
+
+    // Number of entries in the book
+    size_t size() const;
+
+    // Returns a legal book move of the position, or NO_MOVE if the
+    // book doesn't have one. A weighted selection picks moves at random
+    // by their weights, the best selection picks the highest weight.
+    Move probe(const Board& board, Color turn, BookSelection selection) const;
+
+    // Returns the Polyglot hash key of the position
+    uint64_t key(const Board& board, Color turn) const;
+private:
+    struct Entry {
+        uint64_t key;
+        uint16_t move;
+        uint16_t weight;
+    };
+
+    // Decodes the entry at index, the file is big endian
+    Entry entry(size_t index) const;
+
+    // Converts a Polyglot move to a move of the board, castling
+    // is stored as the king capturing its own rook
+    Move decodeMove(const Board& board, uint16_t move) const;
+
+    uint64_t random_[781] = {};
+
+    const unsigned char* data_ = nullptr;
+    size_t count_ = 0;
+    size_t mappedBytes_ = 0;
+};
+
+
+#endif //CHESS_OPENINGBOOK_H
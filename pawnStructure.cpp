@@ -0,0 +1,121 @@
+/* Chess --- pawnStructure.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "pawnStructure.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace Bitboards;
+
+// Penalties of the weak pawns and bonuses of the passed pawns by
+// the rank they have reached, in the units of the piece values
+const int DOUBLED_PAWN = -2;
+const int ISOLATED_PAWN = -2;
+const int BACKWARD_PAWN = -1;
+const int PASSED_PAWN[8] = {0, 1, 1, 2, 4, 7, 11, 0};
+
+namespace {
+    // Squares in front of a pawn on its file, the files next to it,
+    // the squares a passed pawn must not find an enemy pawn on, and
+    // the squares of friendly pawns that could still defend it
+    Bitboard frontSpans[2][64];
+    Bitboard adjacentFiles[8];
+    Bitboard passedMasks[2][64];
+    Bitboard supportMasks[2][64];
+
+    struct Initializer {
+        Initializer() {
+            for (int file = 0; file < 8; file++) {
+                adjacentFiles[file] = (file > 0 ? FILE_A << (file - 1) : 0) | (file < 7 ? FILE_A << (file + 1) : 0);
+            }
+            for (int square = 0; square < 64; square++) {
+                const int file = square % 8;
+                const int rank = square / 8;
+
+                // Ranks above and below the square, and with the square's rank
+                const Bitboard above = rank < 7 ? ~0ULL << (8 * (rank + 1)) : 0;
+                const Bitboard below = rank > 0 ? ~0ULL >> (8 * (8 - rank)) : 0;
+                const Bitboard rankBit = RANK_1 << (8 * rank);
+
+                frontSpans[WHITE][square] = FILE_A << file & above;
+                frontSpans[BLACK][square] = FILE_A << file & below;
+                passedMasks[WHITE][square] = (FILE_A << file | adjacentFiles[file]) & above;
+                passedMasks[BLACK][square] = (FILE_A << file | adjacentFiles[file]) & below;
+                supportMasks[WHITE][square] = adjacentFiles[file] & (below | rankBit);
+                supportMasks[BLACK][square] = adjacentFiles[file] & (above | rankBit);
+            }
+        }
+    } initializer;
+
+    // Score of the pawns of one color, from its point of view
+    int evaluateColor(const Board& board, const Color color) {
+        const Color opponent = color == WHITE ? BLACK : WHITE;
+        const Bitboard own = board.pieces[color][PAWN];
+        const Bitboard enemy = board.pieces[opponent][PAWN];
+        int score = 0;
+
+        Bitboard pawns = own;
+        while (pawns) {
+            const int square = popLsb(pawns);
+            const int file = square % 8;
+            const int rank = color == WHITE ? square / 8 : 7 - square / 8;
+
+            // Only the pawns behind another one count as doubled
+            if (own & frontSpans[color][square]) score += DOUBLED_PAWN;
+
+            // A pawn no friendly pawn can ever defend is isolated, and one
+            // that has left its neighbours behind is backward if it can't
+            // advance safely to get them back
+            if (!(own & adjacentFiles[file])) {
+                score += ISOLATED_PAWN;
+            }
+            else if (!(own & supportMasks[color][square])) {
+                const int stop = square + (color == WHITE ? 8 : -8);
+                if (pawnAttacks(color, stop) & enemy) score += BACKWARD_PAWN;
+            }
+
+            if (!(enemy & passedMasks[color][square]) && !(own & frontSpans[color][square])) {
+                score += PASSED_PAWN[rank];
+            }
+        }
+        return score;
+    }
+}
+
+namespace PawnStructure {
+    int evaluate(const Board& board) {
+        return evaluateColor(board, WHITE) - evaluateColor(board, BLACK);
+    }
+}
+
+PawnTable::PawnTable(const size_t kilobytes) {
+    mask_ = 0;
+    resize(kilobytes);
+}
+
+void PawnTable::resize(const size_t kilobytes) {
+    // The entry count is rounded down to a power of two,
+    // so the index is a mask of the key
+    const size_t entries = bit_floor(max<size_t>(kilobytes * 1024 / sizeof(Entry), 1));
+    entries_.assign(entries, {0, 0});
+    mask_ = entries - 1;
+}
+
+int PawnTable::evaluate(const Board& board, HashStats& stats) {
+    // Boards without pawns have key 0, which
+    // the empty entries score correctly as 0
+    Entry& entry = entries_[board.pawnKey & mask_];
+    stats.probes++;
+    if (entry.key == board.pawnKey) {
+        stats.hits++;
+        return entry.score;
+    }
+
+    stats.stores++;
+    if (entry.key != 0) stats.overwrites++;
+    entry = {board.pawnKey, PawnStructure::evaluate(board)};
+    return entry.score;
+}
@@ -0,0 +1,55 @@
+/* Chess --- pawnStructure.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_PAWNSTRUCTURE_H
+#define CHESS_PAWNSTRUCTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "boardFunctions.h"
+#include "transpositionTable.h"
+
+using namespace std;
+
+// Default size of the pawn hash table of every search thread
+const size_t DEFAULT_PAWN_HASH_KB = 256;
+
+// Namespace that holds the evaluation of the pawn structure
+namespace PawnStructure {
+    // Scores the pawns by how they stand to each other: doubled,
+    // isolated and backward pawns are weaknesses, and passed pawns
+    // are worth more the further they have advanced
+    // The score is from white's point of view
+    int evaluate(const Board& board);
+}
+
+// Hash table of pawn structure scores by the pawn key of the board.
+// The pawns rarely move, so most positions of a search share their
+// structure with one scored before. Every search thread has its own,
+// so it needs no locking
+class PawnTable {
+public:
+    explicit PawnTable(size_t kilobytes = DEFAULT_PAWN_HASH_KB);
+
+    // Reallocates the table, all the entries are lost
+    void resize(size_t kilobytes);
+
+    // Returns the pawn structure score of the board, from the table if
+    // it is stored and computed and stored otherwise. The lookups are
+    // counted in stats
+    int evaluate(const Board& board, HashStats& stats);
+private:
+    struct Entry {
+        uint64_t key;
+        int score;
+    };
+
+    vector<Entry> entries_;
+    size_t mask_;
+};
+
+
+#endif //CHESS_PAWNSTRUCTURE_H
@@ -0,0 +1,132 @@
+/* Chess --- perft.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "perft.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace BoardFunctions;
+using namespace std::chrono;
+
+namespace {
+    // Subtree counts by position and depth, shared by the threads
+    // without locks in the same way as the transposition table,
+    // the key is stored XORed with the data to detect torn slots
+    class PerftTable {
+    public:
+        explicit PerftTable(const size_t megabytes) {
+            size_t count = 1;
+            while (count * 2 * sizeof(Slot) <= megabytes * 1024 * 1024) count *= 2;
+            slots_ = make_unique<Slot[]>(count);
+            mask_ = count - 1;
+        }
+
+        bool probe(const uint64_t key, const int depth, uint64_t& count) const {
+            const Slot& slot = slots_[key & mask_];
+            const uint64_t data = slot.data.load(memory_order_relaxed);
+            if ((slot.check.load(memory_order_relaxed) ^ data) != key || (data & 0xFF) != static_cast<uint64_t>(depth)) {
+                return false;
+            }
+            count = data >> 8;
+            return true;
+        }
+
+        void store(const uint64_t key, const int depth, const uint64_t count) {
+            Slot& slot = slots_[key & mask_];
+            const uint64_t data = count << 8 | static_cast<uint64_t>(depth);
+            slot.data.store(data, memory_order_relaxed);
+            slot.check.store(key ^ data, memory_order_relaxed);
+        }
+    private:
+        struct Slot {
+            atomic<uint64_t> check;
+            atomic<uint64_t> data;
+        };
+
+        unique_ptr<Slot[]> slots_;
+        size_t mask_;
+    };
+
+    uint64_t countMoves(Board& board, const int depth, const Color turn, PerftTable* table) {
+        const Color opponent = turn == WHITE ? BLACK : WHITE;
+        Moves moves;
+        getAllAvailableMoves(board, moves, turn);
+
+        // The moves are legal, so the last ply only needs their number
+        if (depth == 1) return moves.size();
+
+        uint64_t key = 0;
+        if (table) {
+            key = getHashKey(board, turn);
+            uint64_t count;
+            if (table->probe(key, depth, count)) return count;
+        }
+
+        uint64_t count = 0;
+        for (const Move& move : moves) {
+            const UndoInfo undo = makeMove(board, move);
+            count += countMoves(board, depth - 1, opponent, table);
+            unmakeMove(board, move, undo);
+        }
+
+        if (table) table->store(key, depth, count);
+        return count;
+    }
+}
+
+namespace Perft {
+    uint64_t perft(Board& board, const int depth, const Color turn) {
+        if (depth <= 0) return 1;
+        return countMoves(board, depth, turn, nullptr);
+    }
+
+    void run(const Board& board, const Color turn, const PerftOptions& options) {
+        if (options.depth <= 0) {
+            cout << "Depth " << options.depth << ": 1 positions" << endl;
+            return;
+        }
+
+        const auto table = options.hashMegabytes > 0 ? make_unique<PerftTable>(options.hashMegabytes) : nullptr;
+        const Color opponent = turn == WHITE ? BLACK : WHITE;
+
+        Moves moves;
+        getAllAvailableMoves(board, moves, turn);
+        vector<uint64_t> counts(moves.size(), 0);
+
+        const auto start = steady_clock::now();
+
+        // Every root move is a separate job, so the threads
+        // only need their own copy of the board
+        int i;
+        #pragma omp parallel num_threads(options.threads) default(none) \
+            shared(board, moves, counts, options, table, turn, opponent) private(i)
+        {
+            Board threadBoard = board;
+
+            #pragma omp for schedule(dynamic)
+            for (i = 0; i < moves.size(); i++) {
+                const Move move = moves[i];
+                const UndoInfo undo = makeMove(threadBoard, move);
+                counts[i] = options.depth == 1 ? 1 : countMoves(threadBoard, options.depth - 1, opponent, table.get());
+                unmakeMove(threadBoard, move, undo);
+            }
+        }
+
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+
+        uint64_t total = 0;
+        for (int j = 0; j < moves.size(); j++) {
+            if (options.divide) cout << convertMoveToNotation(moves[j]) << ": " << counts[j] << endl;
+            total += counts[j];
+        }
+        if (options.divide) cout << endl;
+        cout << "Depth " << options.depth << ": " << total << " positions" << endl;
+        cout << static_cast<long>(seconds * 1000) << " ms, "
+             << static_cast<uint64_t>(total / max(seconds, 1e-9)) << " positions/s" << endl;
+    }
+}
@@ -0,0 +1,40 @@
+/* Chess --- perft.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_PERFT_H
+#define CHESS_PERFT_H
+
+#include <cstdint>
+#include "boardFunctions.h"
+
+// Options of a perft run
+struct PerftOptions {
+    int depth = 5;
+
+    // Prints the count below every root move
+    bool divide = false;
+
+    // Root moves are counted by this many threads
+    int threads = 1;
+
+    // Size of the table of counted subtrees, 0 disables it
+    size_t hashMegabytes = 0;
+};
+
+// Namespace that holds the move generator test, which counts
+// the positions that can be reached in a given number of moves.
+// The counts can be compared with known results to check the
+// move generation, and the speed is a measure of its performance
+namespace Perft {
+    // Counts the positions reachable with legal moves to the given depth
+    uint64_t perft(Board& board, int depth, Color turn);
+
+    // Runs perft with the options and prints the
+    // counts, the time and the positions per second
+    void run(const Board& board, Color turn, const PerftOptions& options);
+}
+
+
+#endif //CHESS_PERFT_H
@@ -0,0 +1,612 @@
+/* Chess --- server.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "server.h"
+#include "chessBot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace BoardFunctions;
+using namespace std::chrono;
+
+namespace {
+    // Latencies of the last go requests kept for the statistics
+    const size_t LATENCY_SAMPLES = 10000;
+
+    // Set by SIGINT and SIGTERM, the server finishes then
+    volatile sig_atomic_t interrupted = 0;
+
+    void onInterrupt(int) {
+        interrupted = 1;
+    }
+
+    // Opens a socket on the address, listening or connected
+    // Returns -1 with the reason printed if it can't
+    int openSocket(const ServerAddress& address, const bool listening) {
+        const bool local = !address.socketPath.empty();
+        const int socketFile = socket(local ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
+        if (socketFile < 0) {
+            cerr << "Cannot create a socket: " << strerror(errno) << endl;
+            return -1;
+        }
+
+        sockaddr_un unixAddress{};
+        sockaddr_in tcpAddress{};
+        sockaddr* socketAddress;
+        socklen_t length;
+        if (local) {
+            if (address.socketPath.size() >= sizeof(unixAddress.sun_path)) {
+                cerr << "Socket path too long: " << address.socketPath << endl;
+                close(socketFile);
+                return -1;
+            }
+            unixAddress.sun_family = AF_UNIX;
+            strcpy(unixAddress.sun_path, address.socketPath.c_str());
+            socketAddress = reinterpret_cast<sockaddr*>(&unixAddress);
+            length = sizeof(unixAddress);
+            if (listening) unlink(address.socketPath.c_str());
+        }
+        else {
+            tcpAddress.sin_family = AF_INET;
+            tcpAddress.sin_port = htons(static_cast<uint16_t>(address.port));
+            tcpAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socketAddress = reinterpret_cast<sockaddr*>(&tcpAddress);
+            length = sizeof(tcpAddress);
+            const int reuse = 1;
+            setsockopt(socketFile, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+
+        const bool opened = listening ? bind(socketFile, socketAddress, length) == 0 && listen(socketFile, 128) == 0
+                                      : connect(socketFile, socketAddress, length) == 0;
+        if (!opened) {
+            cerr << "Cannot " << (listening ? "listen on " : "connect to ")
+                 << (local ? address.socketPath : "port " + to_string(address.port)) << ": " << strerror(errno) << endl;
+            close(socketFile);
+            return -1;
+        }
+        return socketFile;
+    }
+
+    // Writes the whole line, false if the other side is gone
+    bool sendLine(const int socketFile, const string& line) {
+        const string data = line + "\n";
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const ssize_t written = send(socketFile, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) return false;
+            sent += written;
+        }
+        return true;
+    }
+
+    // Lines arriving on a socket, split as they come in
+    class LineReader {
+    public:
+        explicit LineReader(const int socketFile) : socketFile_(socketFile) {}
+
+        // Reads what has arrived and adds the complete lines
+        // Returns false once the other side has closed
+        bool read(vector<string>& lines) {
+            char data[4096];
+            const ssize_t received = recv(socketFile_, data, sizeof(data), 0);
+            if (received <= 0) return false;
+            buffer_.append(data, received);
+
+            size_t end;
+            while ((end = buffer_.find('\n')) != string::npos) {
+                string line = buffer_.substr(0, end);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                lines.push_back(line);
+                buffer_.erase(0, end + 1);
+            }
+            return true;
+        }
+    private:
+        int socketFile_;
+        string buffer_;
+    };
+
+    // A client of the server. The socket is closed once
+    // neither the I/O thread nor a search holds it any more
+    struct Connection {
+        explicit Connection(const int socketFile) : socketFile(socketFile), reader(socketFile) {}
+        ~Connection() { close(socketFile); }
+
+        void send(const string& line) {
+            lock_guard<mutex> lock(writeMutex);
+            if (open) open = sendLine(socketFile, line);
+        }
+
+        int socketFile;
+        LineReader reader;
+        mutex writeMutex;
+        atomic<bool> open = true;
+    };
+
+    // A command of a game waiting for its turn
+    struct Request {
+        string command;
+        steady_clock::time_point arrival;
+    };
+
+    struct Game {
+        Game(const int id, shared_ptr<Connection> owner, const ServerOptions& options)
+            : id(id), owner(std::move(owner)), bot(options.hashMegabytes) {
+            bot.setThreads(1);
+            bot.setTablebases(options.tablebases);
+            bot.setNetwork(options.network);
+            bot.setPruning(options.pruning);
+            bot.setPawnHashSize(options.pawnHashKilobytes);
+        }
+
+        int id;
+        shared_ptr<Connection> owner;
+        ChessBot bot;
+        Board board{};
+        Color turn = WHITE;
+
+        // Commands not run yet, and if the game waits in the ready queue
+        // or is being served. Both are guarded by the scheduler lock
+        deque<Request> pending;
+        bool scheduled = false;
+        bool closed = false;
+
+        // Stops the running search when the game is closed
+        atomic<bool> stop = false;
+    };
+
+    // Counters of the server, guarded by the scheduler lock
+    struct ServerStats {
+        uint64_t requests = 0;
+        uint64_t searches = 0;
+        uint64_t rejected = 0;
+        uint64_t expired = 0;
+        uint64_t gamesCreated = 0;
+        vector<int64_t> latencies;
+        size_t nextLatency = 0;
+
+        void addLatency(const int64_t milliseconds) {
+            if (latencies.size() < LATENCY_SAMPLES) latencies.push_back(milliseconds);
+            else latencies[nextLatency++ % LATENCY_SAMPLES] = milliseconds;
+        }
+    };
+
+    class GameServer {
+    public:
+        explicit GameServer(const ServerOptions& options) : options_(options) {}
+
+        void start() {
+            for (int i = 0; i < max(1, options_.workers); i++) workers_.emplace_back([this] { work(); });
+        }
+
+        void finish() {
+            {
+                lock_guard<mutex> lock(mutex_);
+                finished_ = true;
+                for (const auto& [id, game] : games_) game->stop = true;
+            }
+            readyChanged_.notify_all();
+            for (thread& worker : workers_) worker.join();
+        }
+
+        // Answers a line of a client, game commands wait for their turn
+        void handle(const shared_ptr<Connection>& connection, const string& line) {
+            istringstream stream(line);
+            string command;
+            if (!(stream >> command)) return;
+
+            if (command == "new") {
+                string keyword, token, fen;
+                stream >> keyword;
+                while (stream >> token) fen += token + " ";
+                Board board;
+                Color turn = WHITE;
+                if (keyword.empty()) populateBoard(board);
+                else if (keyword != "fen" || !loadFen(board, fen, turn)) {
+                    connection->send("error invalid position");
+                    return;
+                }
+
+                auto game = make_shared<Game>(0, connection, options_);
+                game->board = board;
+                game->turn = turn;
+                {
+                    lock_guard<mutex> lock(mutex_);
+                    game->id = ++lastId_;
+                    games_[game->id] = game;
+                    stats_.gamesCreated++;
+                }
+                connection->send("new " + to_string(game->id));
+                return;
+            }
+            if (command == "stats") {
+                connection->send("stats " + statsJson());
+                return;
+            }
+            if (command != "move" && command != "go" && command != "close") {
+                connection->send("error unknown command " + command);
+                return;
+            }
+
+            int id;
+            if (!(stream >> id)) {
+                connection->send("error missing game");
+                return;
+            }
+
+            lock_guard<mutex> lock(mutex_);
+            stats_.requests++;
+            const auto found = games_.find(id);
+            if (found == games_.end() || found->second->owner != connection) {
+                connection->send(to_string(id) + " error unknown game");
+                return;
+            }
+            const shared_ptr<Game>& game = found->second;
+            if (command == "close") {
+                closeGame(game);
+                connection->send(to_string(id) + " closed");
+                return;
+            }
+            if (queued_ >= options_.maxQueued) {
+                stats_.rejected++;
+                connection->send(to_string(id) + " error busy");
+                return;
+            }
+
+            game->pending.push_back({line, steady_clock::now()});
+            queued_++;
+            if (!game->scheduled) {
+                game->scheduled = true;
+                ready_.push_back(game);
+                readyChanged_.notify_one();
+            }
+        }
+
+        // Closes the games of a client that has gone
+        void disconnect(const shared_ptr<Connection>& connection) {
+            lock_guard<mutex> lock(mutex_);
+            vector<shared_ptr<Game>> owned;
+            for (const auto& [id, game] : games_) {
+                if (game->owner == connection) owned.push_back(game);
+            }
+            for (const auto& game : owned) closeGame(game);
+        }
+    private:
+        // Takes the game out of the server, its waiting commands are dropped
+        // and a running search stops. Called with the scheduler lock held
+        void closeGame(const shared_ptr<Game>& game) {
+            game->closed = true;
+            game->stop = true;
+            queued_ -= game->pending.size();
+            game->pending.clear();
+            games_.erase(game->id);
+        }
+
+        // Serves the ready games in turn, one command of a game at a time
+        void work() {
+            while (true) {
+                shared_ptr<Game> game;
+                Request request;
+                {
+                    unique_lock<mutex> lock(mutex_);
+                    readyChanged_.wait(lock, [this] { return finished_ || !ready_.empty(); });
+                    if (finished_) return;
+                    game = ready_.front();
+                    ready_.pop_front();
+                    if (game->closed || game->pending.empty()) {
+                        game->scheduled = false;
+                        continue;
+                    }
+                    request = game->pending.front();
+                    game->pending.pop_front();
+                    queued_--;
+                }
+
+                const string answer = run(*game, request);
+
+                // A game closed while the command ran has answered closed
+                // already, so the command's answer is dropped
+                lock_guard<mutex> lock(mutex_);
+                if (!game->closed) game->owner->send(answer);
+
+                // A game with more commands goes to the back of the
+                // queue, so the games take turns on the workers
+                if (!game->closed && !game->pending.empty()) {
+                    ready_.push_back(game);
+                    readyChanged_.notify_one();
+                }
+                else {
+                    game->scheduled = false;
+                }
+            }
+        }
+
+        // Runs a move or go command of the game
+        // Returns the answer to the client
+        string run(Game& game, const Request& request) {
+            istringstream stream(request.command);
+            string command, token;
+            int id;
+            stream >> command >> id;
+            const string prefix = to_string(id) + " ";
+
+            if (command == "move") {
+                stream >> token;
+                const Move move = convertNotationToMove(game.board, token, game.turn);
+                if (move == NO_MOVE) return prefix + "error illegal move " + token;
+                makeMove(game.board, move);
+                game.turn = game.turn == WHITE ? BLACK : WHITE;
+                return prefix + "ok";
+            }
+
+            SearchLimits limits;
+            limits.depth = options_.depth;
+            limits.milliseconds = options_.milliseconds;
+            int64_t deadline = options_.deadline;
+            while (stream >> token) {
+                if (token == "movetime") stream >> limits.milliseconds;
+                else if (token == "depth") stream >> limits.depth;
+                else if (token == "deadline") stream >> deadline;
+            }
+            limits.depth = clamp(limits.depth, 1, MAX_PLY - 1);
+
+            const GameState state = getGameState(game.board, game.turn);
+            if (state != ONGOING) return prefix + "error game over by " + (state == CHECKMATE ? "checkmate" : "stalemate");
+
+            // The search gets what is left until the deadline at most
+            const auto start = steady_clock::now();
+            const int64_t queued = duration_cast<milliseconds>(start - request.arrival).count();
+            if (deadline > 0) {
+                const int64_t left = deadline - queued;
+                if (left <= 0) {
+                    lock_guard<mutex> lock(mutex_);
+                    stats_.expired++;
+                    return prefix + "error deadline";
+                }
+                limits.milliseconds = limits.milliseconds > 0 ? min(limits.milliseconds, left) : left;
+            }
+
+            limits.stop = &game.stop;
+            const auto [score, move] = game.bot.search(game.board, game.turn, limits);
+            const vector<Move> line = game.bot.principalVariation();
+            const int depth = game.bot.completedDepth();
+            const uint64_t nodes = game.bot.stats().nodes;
+            const int64_t elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+            if (move == NO_MOVE) return prefix + "error no move";
+
+            makeMove(game.board, move);
+            const int sideScore = game.turn == WHITE ? score : -score;
+            game.turn = game.turn == WHITE ? BLACK : WHITE;
+            {
+                lock_guard<mutex> lock(mutex_);
+                stats_.searches++;
+                stats_.addLatency(queued + elapsed);
+            }
+
+            // A pawn is 10 in the evaluation and 100 centipawns
+            const int mate = movesToMate(sideScore);
+            return prefix + "bestmove " + convertMoveToNotation(move) + " score " +
+                   (mate ? "mate " + to_string(mate) : "cp " + to_string(sideScore * 10)) +
+                   " depth " + to_string(depth) + " nodes " + to_string(nodes) + " queued " + to_string(queued) +
+                   " time " + to_string(elapsed) + " pv " + convertLineToNotation(line);
+        }
+
+        string statsJson() {
+            lock_guard<mutex> lock(mutex_);
+            vector<int64_t> latencies = stats_.latencies;
+            sort(latencies.begin(), latencies.end());
+            auto percentile = [&](const double share) {
+                return latencies.empty() ? 0 : latencies[static_cast<size_t>(share * (latencies.size() - 1))];
+            };
+
+            ostringstream json;
+            json << "{\"games\":" << games_.size() << ",\"gamesCreated\":" << stats_.gamesCreated
+                 << ",\"workers\":" << workers_.size() << ",\"queued\":" << queued_
+                 << ",\"requests\":" << stats_.requests << ",\"searches\":" << stats_.searches
+                 << ",\"rejected\":" << stats_.rejected << ",\"expired\":" << stats_.expired
+                 << ",\"latency\":{\"p50\":" << percentile(0.5) << ",\"p90\":" << percentile(0.9)
+                 << ",\"p99\":" << percentile(0.99) << ",\"max\":" << (latencies.empty() ? 0 : latencies.back())
+                 << "}}";
+            return json.str();
+        }
+
+        const ServerOptions& options_;
+        vector<thread> workers_;
+
+        // Guards everything below
+        mutex mutex_;
+        condition_variable readyChanged_;
+        map<int, shared_ptr<Game>> games_;
+        deque<shared_ptr<Game>> ready_;
+        size_t queued_ = 0;
+        int lastId_ = 0;
+        bool finished_ = false;
+        ServerStats stats_;
+    };
+}
+
+namespace Server {
+    bool run(const ServerOptions& options) {
+        const int listener = openSocket(options.address, true);
+        if (listener < 0) return false;
+
+        signal(SIGINT, onInterrupt);
+        signal(SIGTERM, onInterrupt);
+
+        GameServer server(options);
+        server.start();
+        cout << "Listening on " << (options.address.socketPath.empty() ? "port " + to_string(options.address.port)
+                                                                       : options.address.socketPath)
+             << " with " << options.workers << " workers" << endl;
+
+        // One thread does all the reading, the searches run on the workers
+        // and answer their clients themselves
+        vector<shared_ptr<Connection>> connections;
+        while (!interrupted) {
+            vector<pollfd> files = {{listener, POLLIN, 0}};
+            for (const auto& connection : connections) files.push_back({connection->socketFile, POLLIN, 0});
+            if (poll(files.data(), files.size(), 200) <= 0) continue;
+
+            vector<shared_ptr<Connection>> open;
+            for (size_t i = 1; i < files.size(); i++) {
+                const shared_ptr<Connection>& connection = connections[i - 1];
+                bool alive = true;
+                if (files[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    vector<string> lines;
+                    alive = connection->reader.read(lines);
+                    for (const string& line : lines) {
+                        if (line == "quit") alive = false;
+                        if (!alive) break;
+                        server.handle(connection, line);
+                    }
+                }
+                if (alive) {
+                    open.push_back(connection);
+                }
+                else {
+                    server.disconnect(connection);
+                    connection->open = false;
+                    shutdown(connection->socketFile, SHUT_RDWR);
+                }
+            }
+            connections = std::move(open);
+
+            if (files[0].revents & POLLIN) {
+                const int client = accept(listener, nullptr, nullptr);
+                if (client >= 0) connections.push_back(make_shared<Connection>(client));
+            }
+        }
+
+        cout << "Shutting down" << endl;
+        for (const auto& connection : connections) server.disconnect(connection);
+        server.finish();
+        close(listener);
+        if (!options.address.socketPath.empty()) unlink(options.address.socketPath.c_str());
+        return true;
+    }
+}
+
+namespace Client {
+    bool run(const ClientOptions& options) {
+        const int server = openSocket(options.address, false);
+        if (server < 0) return false;
+
+        // Answers may come at any time, so they are printed by their own thread
+        thread printer([server] {
+            LineReader reader(server);
+            vector<string> lines;
+            while (reader.read(lines)) {
+                for (const string& line : lines) cout << line << endl;
+                lines.clear();
+            }
+        });
+
+        string line;
+        while (getline(cin, line) && sendLine(server, line) && line != "quit") {}
+        shutdown(server, SHUT_WR);
+        printer.join();
+        close(server);
+        return true;
+    }
+
+    bool loadTest(const ClientOptions& options) {
+        // Checks that the server is there before starting the games
+        const int probe = openSocket(options.address, false);
+        if (probe < 0) return false;
+        close(probe);
+
+        string go;
+        if (options.milliseconds > 0) go += " movetime " + to_string(options.milliseconds);
+        if (options.depth > 0) go += " depth " + to_string(options.depth);
+        if (options.deadline > 0) go += " deadline " + to_string(options.deadline);
+
+        mutex resultMutex;
+        vector<int64_t> latencies;
+        uint64_t errors = 0;
+        const auto start = steady_clock::now();
+
+        // Every game is a client of its own, asking for a move as soon
+        // as the last one arrived, with the server playing both sides
+        vector<thread> games;
+        for (int i = 0; i < max(1, options.games); i++) {
+            games.emplace_back([&] {
+                const int server = openSocket(options.address, false);
+                if (server < 0) {
+                    lock_guard<mutex> lock(resultMutex);
+                    errors++;
+                    return;
+                }
+                LineReader reader(server);
+                vector<string> lines;
+                auto request = [&](const string& line) {
+                    lines.clear();
+                    if (!sendLine(server, line)) return string();
+                    while (lines.empty() && reader.read(lines)) {}
+                    return lines.empty() ? string() : lines[0];
+                };
+
+                const string created = request("new");
+                if (created.rfind("new ", 0) != 0) {
+                    lock_guard<mutex> lock(resultMutex);
+                    errors++;
+                    close(server);
+                    return;
+                }
+                const string id = created.substr(4);
+
+                vector<int64_t> gameLatencies;
+                uint64_t gameErrors = 0;
+                for (int move = 0; move < options.moves; move++) {
+                    const auto sent = steady_clock::now();
+                    const string answer = request("go " + id + go);
+                    gameLatencies.push_back(duration_cast<milliseconds>(steady_clock::now() - sent).count());
+                    if (answer.find(" bestmove ") == string::npos) {
+                        // A finished game ends the test of this client
+                        if (answer.find("game over") != string::npos) break;
+                        gameErrors++;
+                    }
+                }
+                request("close " + id);
+                close(server);
+
+                lock_guard<mutex> lock(resultMutex);
+                latencies.insert(latencies.end(), gameLatencies.begin(), gameLatencies.end());
+                errors += gameErrors;
+            });
+        }
+        for (thread& game : games) game.join();
+
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+        sort(latencies.begin(), latencies.end());
+        auto percentile = [&](const double share) {
+            return latencies.empty() ? 0 : latencies[static_cast<size_t>(share * (latencies.size() - 1))];
+        };
+        cout << options.games << " games, " << latencies.size() << " requests, " << errors << " errors in "
+             << fixed << setprecision(1) << seconds << " s, " << latencies.size() / max(seconds, 1e-9)
+             << " requests/s" << endl;
+        cout << "Latency (ms): p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 "
+             << percentile(0.99) << ", max " << (latencies.empty() ? 0 : latencies.back()) << endl;
+        return true;
+    }
+}
@@ -0,0 +1,111 @@
+/* Chess --- server.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_SERVER_H
+#define CHESS_SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "chessBot.h"
+#include "nnue.h"
+#include "tablebases.h"
+
+using namespace std;
+
+// Transposition table size of every game of the server, small
+// because a server holds many games and searches them briefly
+const size_t SERVER_HASH_MB = 4;
+
+// Where the server listens and the clients connect: a Unix socket
+// when the path is set, otherwise a TCP port on the loopback address
+struct ServerAddress {
+    string socketPath;
+    int port = 7070;
+};
+
+// Options of the game server
+struct ServerOptions {
+    ServerAddress address;
+
+    // Searches run at the same time, every search uses one thread
+    int workers = 1;
+
+    // Requests waiting for a worker, more are turned down as busy
+    size_t maxQueued = 1024;
+
+    // Transposition table size of every game
+    size_t hashMegabytes = SERVER_HASH_MB;
+
+    // Pawn hash table size of every game
+    size_t pawnHashKilobytes = DEFAULT_PAWN_HASH_KB;
+
+    // Limits of a go request that doesn't set its own, a zero time and
+    // deadline aren't checked. The deadline counts from the arrival of the
+    // request, a request still waiting at its deadline isn't searched and
+    // a running search is stopped there
+    int depth = MAX_PLY - 1;
+    int64_t milliseconds = 100;
+    int64_t deadline = 0;
+
+    // Shared by the bots of all the games
+    const Tablebases* tablebases = nullptr;
+    const Network* network = nullptr;
+    PruningOptions pruning;
+};
+
+// Options of the client and the load generator
+struct ClientOptions {
+    ServerAddress address;
+
+    // Games the load generator plays at the same time, each on its own
+    // connection, and the moves the server plays in each of them
+    int games = 8;
+    int moves = 40;
+
+    // Limits sent with every go request, zero leaves them to the server
+    int64_t milliseconds = 0;
+    int depth = 0;
+    int64_t deadline = 0;
+};
+
+// Namespace that holds the game server. It hosts any number of games,
+// each with its own position and bot, for the clients that connect
+// Commands are lines of text, and every answer is a line:
+//   new [fen <FEN>]                    -> new <id>
+//   move <id> <move>                   -> <id> ok
+//   go <id> [movetime <ms>] [depth <n>] [deadline <ms>]
+//                                      -> <id> bestmove <move> score <cp | mate n> depth <n>
+//                                         nodes <n> queued <ms> time <ms> pv <moves>
+//   close <id>                         -> <id> closed
+//   stats                              -> stats <JSON>
+//   quit
+// Failures are answered with "[<id>] error <reason>". Games belong to the
+// connection that created them and are closed with it. Closing a game
+// stops its running command, which then isn't answered. The commands of a
+// game run in order, and the games with waiting commands take turns on a
+// fixed pool of workers, so one busy game can't hold the others back
+namespace Server {
+    // Serves until interrupted
+    // Returns false if the address can't be listened on
+    bool run(const ServerOptions& options);
+}
+
+// Namespace that holds the clients of the game server
+namespace Client {
+    // Sends the lines of the standard input to the server
+    // and prints its answers until either side closes
+    // Returns false if the server can't be reached
+    bool run(const ClientOptions& options);
+
+    // Plays games on the server from many connections at once, the
+    // server playing both sides, and prints the latency of the go
+    // requests seen by the clients
+    // Returns false if the server can't be reached
+    bool loadTest(const ClientOptions& options);
+}
+
+
+#endif //CHESS_SERVER_H
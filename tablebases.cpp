@@ -0,0 +1,604 @@
+/* Chess --- tablebases.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "tablebases.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace BoardFunctions;
+using namespace Bitboards;
+
+namespace {
+    // Distance bytes that aren't a distance to mate. Positions that
+    // aren't solved when the building ends are draws, so a draw
+    // and a position that isn't solved yet have the same byte
+    const uint8_t DRAW = 0xFF;
+    const uint8_t ILLEGAL = 0xFE;
+    const int MAX_DISTANCE = 0xFD;
+
+    // Every table file starts with this, followed by the distances
+    const char MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'T', 'B', '1'};
+
+    // Non king pieces get a code from 1 to 10, and a material the key
+    // of its codes, the higher one first and 0 for a missing piece
+    const int CODES = 11;
+
+    int pieceCode(const Color color, const PieceType type) {
+        return 1 + color * 5 + type;
+    }
+
+    int materialKey(const int first, const int second) {
+        return max(first, second) * CODES + min(first, second);
+    }
+
+    Color opponent(const Color color) {
+        return color == WHITE ? BLACK : WHITE;
+    }
+
+    // Order of the distance bytes for the side to move: the faster
+    // win first, then a draw, then the slower loss
+    int distanceRank(const uint8_t plies) {
+        return plies == DRAW ? 0 : plies % 2 ? 1000 - plies : plies - 1000;
+    }
+
+    // Distance byte of a position reached by a move from
+    // a position with the given distance byte
+    uint8_t parentDistance(const uint8_t plies) {
+        return plies == DRAW || plies >= MAX_DISTANCE ? DRAW : plies + 1;
+    }
+
+    char pieceChar(const Color color, const PieceType type) {
+        const char piece = "pnbrqk"[type];
+        return color == WHITE ? piece : static_cast<char>(toupper(piece));
+    }
+
+    // Squares a piece can have come from without capturing
+    Bitboard origins(const Board& board, const int square, const Color color) {
+        const Bitboard empty = ~board.occupied;
+        switch (getPieceType(board[square])) {
+            case KNIGHT: return knightAttacks(square) & empty;
+            case BISHOP: return bishopAttacks(square, board.occupied) & empty;
+            case ROOK: return rookAttacks(square, board.occupied) & empty;
+            case QUEEN: return queenAttacks(square, board.occupied) & empty;
+            case KING: return kingAttacks(square) & empty;
+            default: break;
+        }
+
+        // A pawn moved one square forward, or two from its first
+        // rank, and never stands on the rank behind that
+        const int forward = color == WHITE ? 8 : -8;
+        const int back = square - forward;
+        if (back < 8 || back >= 56 || board[back] != '0') return 0;
+        Bitboard result = squareBit(back);
+        if (square / 8 == (color == WHITE ? 3 : 4) && board[back - forward] == '0') {
+            result |= squareBit(back - forward);
+        }
+        return result;
+    }
+}
+
+// Positions are indexed by the side to move, the white king on one of
+// the 32 squares of the files a to d, the black king and the other
+// pieces in the order of pieces, each on one of the 64 squares
+struct Tablebases::Table {
+    string name;
+
+    // Non king pieces, white ones first, both colors strongest first
+    vector<pair<Color, PieceType>> pieces;
+    int pawns = 0;
+
+    // Positions of the table
+    size_t size = 0;
+
+    // Distance to mate of every position, in the mapped file
+    // or in values while the table is being built
+    const uint8_t* data = nullptr;
+    vector<uint8_t> values;
+
+    void* mapping = nullptr;
+    size_t mappedBytes = 0;
+
+    ~Table() {
+        if (mapping) munmap(mapping, mappedBytes);
+    }
+};
+
+Tablebases::Tablebases() : lookups_(CODES * CODES) {
+    const PieceType types[] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+    const auto addTable = [this](const vector<PieceType>& white, const vector<PieceType>& black) {
+        auto table = make_unique<Table>();
+        string letters[2];
+        for (const PieceType type : white) table->pieces.emplace_back(WHITE, type);
+        for (const PieceType type : black) table->pieces.emplace_back(BLACK, type);
+        for (const auto& [color, type] : table->pieces) {
+            letters[color] += "PNBRQ"[type];
+            if (type == PAWN) table->pawns++;
+        }
+        table->name = "K" + letters[WHITE] + "vK" + letters[BLACK];
+
+        table->size = 2 * 32;
+        for (size_t i = 0; i <= table->pieces.size(); i++) table->size *= 64;
+        tables_.push_back(move(table));
+    };
+
+    // White always has the stronger pieces, the
+    // other materials are their colors swapped
+    for (int i = 0; i < 5; i++) addTable({types[i]}, {});
+    for (int i = 0; i < 5; i++) {
+        for (int j = i; j < 5; j++) addTable({types[i], types[j]}, {});
+    }
+    for (int i = 0; i < 5; i++) {
+        for (int j = i; j < 5; j++) addTable({types[i]}, {types[j]});
+    }
+
+    // A promotion leads to a table with one pawn less, so
+    // those have to be built before the ones with more pawns
+    stable_sort(tables_.begin(), tables_.end(), [](const auto& a, const auto& b) {
+        if (a->pieces.size() != b->pieces.size()) return a->pieces.size() < b->pieces.size();
+        return a->pawns < b->pawns;
+    });
+}
+
+Tablebases::~Tablebases() = default;
+
+bool Tablebases::open(const string& directory) {
+    error_code error;
+    if (!filesystem::is_directory(directory, error)) return false;
+
+    for (const auto& table : tables_) {
+        if (!table->data && map(*table, directory + "/" + table->name + ".tb")) registerTable(*table);
+    }
+    return true;
+}
+
+int Tablebases::size() const {
+    int count = 0;
+    for (const auto& table : tables_) count += table->data != nullptr;
+    return count;
+}
+
+void Tablebases::registerTable(const Table& table) {
+    int codes[2] = {0, 0};
+    int swappedCodes[2] = {0, 0};
+    for (size_t i = 0; i < table.pieces.size(); i++) {
+        const auto& [color, type] = table.pieces[i];
+        codes[i] = pieceCode(color, type);
+        swappedCodes[i] = pieceCode(opponent(color), type);
+    }
+
+    // Materials that are the same with their colors swapped, like
+    // KRvKR, keep both sides in the table without swapping
+    lookups_[materialKey(codes[0], codes[1])] = {&table, false};
+    Lookup& swapped = lookups_[materialKey(swappedCodes[0], swappedCodes[1])];
+    if (!swapped.table) swapped = {&table, true};
+}
+
+bool Tablebases::locate(const Board& board, const Color turn, const Table*& table, size_t& index) const {
+    const int count = popCount(board.occupied);
+    if (count < 3 || count > MAX_PIECES) return false;
+    if (board.kingSquares[WHITE] == NO_SQUARE || board.kingSquares[BLACK] == NO_SQUARE) return false;
+
+    int codes[2] = {0, 0};
+    int found = 0;
+    for (int color = WHITE; color <= BLACK; color++) {
+        for (int type = PAWN; type < KING; type++) {
+            for (Bitboard pieces = board.pieces[color][type]; pieces; pieces &= pieces - 1) {
+                codes[found++] = pieceCode(static_cast<Color>(color), static_cast<PieceType>(type));
+            }
+        }
+    }
+    const Lookup& lookup = lookups_[materialKey(codes[0], codes[1])];
+    if (!lookup.table) return false;
+    table = lookup.table;
+
+    // Swapping the colors also turns the board upside
+    // down, so the pawns keep moving up for white
+    const int flip = lookup.swapped ? 56 : 0;
+    const Color white = lookup.swapped ? BLACK : WHITE;
+    int squares[MAX_PIECES];
+    squares[0] = board.kingSquares[white] ^ flip;
+    squares[1] = board.kingSquares[opponent(white)] ^ flip;
+
+    int pieceCount = 2;
+    Bitboard used = 0;
+    for (const auto& [color, type] : table->pieces) {
+        const int square = lsb(board.pieces[lookup.swapped ? opponent(color) : color][type] & ~used);
+        used |= squareBit(square);
+        squares[pieceCount++] = square ^ flip;
+    }
+
+    const int mirror = squares[0] % 8 >= 4 ? 7 : 0;
+    for (int i = 0; i < pieceCount; i++) squares[i] ^= mirror;
+
+    // Pieces of the same kind are stored with the lower square first
+    for (int i = 3; i < pieceCount; i++) {
+        if (table->pieces[i - 2] == table->pieces[i - 3] && squares[i] < squares[i - 1]) {
+            swap(squares[i], squares[i - 1]);
+        }
+    }
+
+    index = ((turn == WHITE) != lookup.swapped ? 0 : 32) + squares[0] / 8 * 4 + squares[0] % 8;
+    for (int i = 1; i < pieceCount; i++) index = index * 64 + squares[i];
+    return true;
+}
+
+uint8_t Tablebases::value(const Table& table, const size_t index) {
+    return atomic_ref<uint8_t>(const_cast<uint8_t&>(table.data[index])).load(memory_order_relaxed);
+}
+
+uint8_t Tablebases::distance(const Board& board, const Color turn) const {
+    // The tables don't have en passant squares, so after a double
+    // push the side to move either plays as if there was none
+    // or captures, whichever is better for it. When the capture
+    // is its only move, the table has a stalemate instead
+    uint8_t capture;
+    bool otherMoves;
+    if (board.enPassantSquare != NO_SQUARE && enPassantDistance(board, turn, capture, otherMoves)) {
+        if (!otherMoves) return capture;
+        Board plain = board;
+        plain.enPassantSquare = NO_SQUARE;
+        const uint8_t plies = distance(plain, turn);
+        return distanceRank(capture) > distanceRank(plies) ? capture : plies;
+    }
+
+    const Table* table;
+    size_t index;
+    if (!locate(board, turn, table, index)) return DRAW;
+    return value(*table, index);
+}
+
+bool Tablebases::enPassantDistance(const Board& board, const Color turn, uint8_t& best, bool& otherMoves) const {
+    Board copy = board;
+    Moves moves;
+    getAllAvailableMoves(copy, moves, turn);
+
+    bool found = false;
+    otherMoves = false;
+    for (const Move move : moves) {
+        if (move.flag() != EN_PASSANT) {
+            otherMoves = true;
+            continue;
+        }
+        const UndoInfo undo = makeMove(copy, move);
+        const uint8_t plies = parentDistance(distance(copy, opponent(turn)));
+        unmakeMove(copy, move, undo);
+
+        if (!found || distanceRank(plies) > distanceRank(best)) best = plies;
+        found = true;
+    }
+    return found;
+}
+
+bool Tablebases::decode(const Table& table, size_t index, Board& board, Color& turn) {
+    const int pieceCount = static_cast<int>(table.pieces.size()) + 2;
+    int squares[MAX_PIECES];
+    for (int i = pieceCount - 1; i >= 1; i--) {
+        squares[i] = static_cast<int>(index % 64);
+        index /= 64;
+    }
+    const int king = static_cast<int>(index % 32);
+    squares[0] = king / 4 * 8 + king % 4;
+    turn = index / 32 ? BLACK : WHITE;
+
+    Bitboard used = 0;
+    for (int i = 0; i < pieceCount; i++) {
+        if (used & squareBit(squares[i])) return false;
+        used |= squareBit(squares[i]);
+    }
+
+    clearBoard(board);
+    putPiece(board, pieceChar(WHITE, KING), squares[0]);
+    putPiece(board, pieceChar(BLACK, KING), squares[1]);
+    for (int i = 2; i < pieceCount; i++) {
+        const auto& [color, type] = table.pieces[i - 2];
+        if (type == PAWN && (squares[i] < 8 || squares[i] >= 56)) return false;
+        if (i > 2 && table.pieces[i - 2] == table.pieces[i - 3] && squares[i] < squares[i - 1]) return false;
+        putPiece(board, pieceChar(color, type), squares[i]);
+    }
+
+    // The side that just moved can't be in check
+    return !isInCheck(board, opponent(turn));
+}
+
+bool Tablebases::probe(const Board& board, const Color turn, TablebaseResult& result) const {
+    if (board.castlingRights || board.enPassantSquare != NO_SQUARE) return false;
+
+    // Two kings alone can't mate
+    if (popCount(board.occupied) == 2 && board.kingSquares[WHITE] != NO_SQUARE &&
+        board.kingSquares[BLACK] != NO_SQUARE) {
+        result = {TB_DRAW, 0};
+        return true;
+    }
+
+    const Table* table;
+    size_t index;
+    if (!locate(board, turn, table, index)) return false;
+    const uint8_t plies = value(*table, index);
+    if (plies == ILLEGAL) return false;
+    if (plies == DRAW) result = {TB_DRAW, 0};
+    else result = {plies % 2 ? TB_WIN : TB_LOSS, plies};
+    return true;
+}
+
+Move Tablebases::bestMove(const Board& board, const Color turn, TablebaseResult& result) const {
+    if (!probe(board, turn, result)) return NO_MOVE;
+
+    Board copy = board;
+    Moves moves;
+    getAllAvailableMoves(copy, moves, turn);
+
+    // Odd distances are wins of the side to move, so they
+    // are losses of the side that made the move
+    Move best = NO_MOVE;
+    int bestRank = INT_MIN;
+    for (const Move move : moves) {
+        const UndoInfo undo = makeMove(copy, move);
+        const uint8_t plies = distance(copy, opponent(turn));
+        unmakeMove(copy, move, undo);
+
+        const int rank = -distanceRank(plies);
+        if (rank > bestRank) {
+            bestRank = rank;
+            best = move;
+        }
+    }
+    return best;
+}
+
+bool Tablebases::solve(Board& board, const Color turn, const int plies) const {
+    Moves moves;
+    getAllAvailableMoves(board, moves, turn);
+
+    // A win needs one move to a position lost in one ply less, a loss
+    // needs every move to go to a position won in less plies. Positions
+    // solved in this round have the distance of the round, so they are
+    // treated like the ones that aren't solved yet
+    for (const Move move : moves) {
+        const UndoInfo undo = makeMove(board, move);
+        const uint8_t child = distance(board, opponent(turn));
+        unmakeMove(board, move, undo);
+
+        const bool solved = child < plies;
+        if (plies % 2) {
+            if (solved && child % 2 == 0) return true;
+        }
+        else if (!solved || child % 2 == 0) return false;
+    }
+    return !moves.empty() && plies % 2 == 0;
+}
+
+void Tablebases::markPredecessors(Board& board, const Color turn, const Table& table,
+                                  vector<uint64_t>& marks) const {
+    const Color mover = opponent(turn);
+    Bitboard pieces = board.colors[mover];
+    while (pieces) {
+        const int square = popLsb(pieces);
+        Bitboard squares = origins(board, square, mover);
+        while (squares) {
+            // Moving the piece back only moves it, so
+            // makeMove can take it to the earlier position
+            const Move move(square, popLsb(squares));
+            const UndoInfo undo = makeMove(board, move);
+            const Table* found;
+            size_t index;
+            if (locate(board, mover, found, index) && found == &table) {
+                atomic_ref<uint64_t>(marks[index / 64]).fetch_or(1ULL << index % 64, memory_order_relaxed);
+            }
+            unmakeMove(board, move, undo);
+        }
+    }
+}
+
+void Tablebases::build(Table& table, const int threads) {
+    table.values.assign(table.size, DRAW);
+    table.data = table.values.data();
+    registerTable(table);
+
+    const size_t words = (table.size + 63) / 64;
+    vector<uint64_t> marks(words, 0);
+    vector<uint64_t> candidates(words, 0);
+
+    // Captures and promotions go to tables that are already built,
+    // so the round that they can solve a position in is known from
+    // the start. Those positions are added to the candidates of it
+    vector<vector<uint32_t>> wakeUps(MAX_DISTANCE + 1);
+    int lastWakeUp = 0;
+
+    // Round 0 finds the mates and the rounds of the captures and promotions
+    #pragma omp parallel num_threads(threads) default(none) shared(table, marks, wakeUps, lastWakeUp)
+    {
+        vector<pair<int, uint32_t>> wakes;
+
+        #pragma omp for schedule(dynamic, 4096)
+        for (size_t index = 0; index < table.size; index++) {
+            Board board;
+            Color turn;
+            if (!decode(table, index, board, turn)) {
+                atomic_ref<uint8_t>(table.values[index]).store(ILLEGAL, memory_order_relaxed);
+                continue;
+            }
+
+            Moves moves;
+            getAllAvailableMoves(board, moves, turn);
+            bool allWins = true;
+            int winRound = 0;
+            int lossRound = 0;
+            for (const Move move : moves) {
+                // Double pushes count too, their en passant captures
+                // go to tables that are already built
+                const bool doublePush = getPieceType(board[move.start()]) == PAWN &&
+                                        abs(move.end() - move.start()) == 16;
+                if (board[move.end()] == '0' && !move.isPromotion() && move.flag() != EN_PASSANT &&
+                    !doublePush) continue;
+
+                const UndoInfo undo = makeMove(board, move);
+                const bool enPassant = board.enPassantSquare != NO_SQUARE;
+                const uint8_t child = distance(board, opponent(turn));
+
+                // The capture alone can decide the double push, once the rest
+                // of the child is solved. Waking the position up at that round
+                // is harmless if it doesn't
+                uint8_t capture;
+                bool otherMoves;
+                if (enPassant && enPassantDistance(board, opponent(turn), capture, otherMoves) &&
+                    parentDistance(capture) != DRAW) {
+                    wakes.emplace_back(parentDistance(capture), index);
+                }
+                unmakeMove(board, move, undo);
+
+                // Other double pushes are quiet moves
+                if (doublePush && !enPassant) continue;
+
+                if (child == DRAW) allWins = false;
+                else if (child % 2 == 0) winRound = winRound ? min(winRound, child + 1) : child + 1;
+                else lossRound = max(lossRound, child + 1);
+            }
+
+            if (moves.empty()) {
+                // Mate, a stalemate stays a draw
+                if (isInCheck(board, turn)) {
+                    atomic_ref<uint8_t>(table.values[index]).store(0, memory_order_relaxed);
+                    markPredecessors(board, turn, table, marks);
+                }
+                continue;
+            }
+            if (winRound && winRound <= MAX_DISTANCE) wakes.emplace_back(winRound, index);
+            if (allWins && lossRound && lossRound <= MAX_DISTANCE) wakes.emplace_back(lossRound, index);
+        }
+
+        #pragma omp critical(tablebaseWakeUps)
+        for (const auto& [round, index] : wakes) {
+            wakeUps[round].push_back(index);
+            lastWakeUp = max(lastWakeUp, round);
+        }
+    }
+
+    // Round n solves the positions mated in n plies, wins in odd rounds
+    // and losses in even ones. Only the positions a move away from the
+    // ones of the last round, and the woken up ones, can be solved
+    for (int plies = 1; plies <= MAX_DISTANCE; plies++) {
+        swap(candidates, marks);
+        fill(marks.begin(), marks.end(), 0);
+        for (const uint32_t index : wakeUps[plies]) candidates[index / 64] |= 1ULL << index % 64;
+        if (plies > lastWakeUp && all_of(candidates.begin(), candidates.end(), [](const uint64_t word) {
+            return word == 0;
+        })) break;
+
+        #pragma omp parallel for num_threads(threads) schedule(dynamic, 64) default(none) \
+            shared(table, candidates, marks, words, plies)
+        for (size_t word = 0; word < words; word++) {
+            Bitboard bits = candidates[word];
+            while (bits) {
+                const size_t index = word * 64 + popLsb(bits);
+                if (value(table, index) != DRAW) continue;
+
+                Board board;
+                Color turn;
+                decode(table, index, board, turn);
+                if (!solve(board, turn, plies)) continue;
+                atomic_ref<uint8_t>(table.values[index]).store(plies, memory_order_relaxed);
+                markPredecessors(board, turn, table, marks);
+            }
+        }
+    }
+}
+
+bool Tablebases::write(const Table& table, const string& path) {
+    // Written next to the table and renamed, so a
+    // broken run never leaves a partial table behind
+    const string temporary = path + ".tmp";
+    ofstream file(temporary, ios::binary);
+    file.write(MAGIC, sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(table.data), static_cast<streamsize>(table.size));
+    file.close();
+    if (!file) return false;
+
+    error_code error;
+    filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+bool Tablebases::map(Table& table, const string& path) {
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat status{};
+    if (fstat(file, &status) != 0 || static_cast<size_t>(status.st_size) != sizeof(MAGIC) + table.size) {
+        ::close(file);
+        return false;
+    }
+
+    // The mapping stays valid after the file is closed
+    void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (mapping == MAP_FAILED) return false;
+    if (memcmp(mapping, MAGIC, sizeof(MAGIC)) != 0) {
+        munmap(mapping, status.st_size);
+        return false;
+    }
+
+    // Probes jump around the whole table
+    madvise(mapping, status.st_size, MADV_RANDOM);
+
+    table.values.clear();
+    table.values.shrink_to_fit();
+    table.mapping = mapping;
+    table.mappedBytes = status.st_size;
+    table.data = static_cast<const uint8_t*>(mapping) + sizeof(MAGIC);
+    return true;
+}
+
+bool Tablebases::generate(const string& directory, const int maxPieces, const int threads) {
+    error_code error;
+    filesystem::create_directories(directory, error);
+    if (!open(directory)) {
+        cout << "Cannot open " << directory << endl;
+        return false;
+    }
+
+    for (const auto& table : tables_) {
+        if (static_cast<int>(table->pieces.size()) + 2 > maxPieces) continue;
+        if (table->data) {
+            cout << table->name << ": already built" << endl;
+            continue;
+        }
+
+        const auto start = chrono::steady_clock::now();
+        build(*table, threads);
+
+        size_t wins = 0, losses = 0, draws = 0;
+        int longest = 0;
+        for (const uint8_t plies : table->values) {
+            if (plies == ILLEGAL) continue;
+            if (plies == DRAW) draws++;
+            else {
+                if (plies % 2) wins++;
+                else losses++;
+                longest = max(longest, static_cast<int>(plies));
+            }
+        }
+
+        const string path = directory + "/" + table->name + ".tb";
+        if (!write(*table, path) || !map(*table, path)) {
+            cout << "Cannot write " << path << endl;
+            return false;
+        }
+        cout << table->name << ": " << wins << " wins, " << losses << " losses, " << draws
+             << " draws, longest mate " << longest << " plies, "
+             << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count()
+             << " ms" << endl;
+    }
+    return true;
+}
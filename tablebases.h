@@ -0,0 +1,131 @@
+/* Chess --- tablebases.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_TABLEBASES_H
+#define CHESS_TABLEBASES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "boardFunctions.h"
+
+using namespace std;
+
+enum TablebaseOutcome {TB_LOSS = -1, TB_DRAW = 0, TB_WIN = 1};
+
+// Result of a position in the tablebases, for the side to move
+struct TablebaseResult {
+    TablebaseOutcome outcome;
+
+    // Plies until mate when both sides play their best,
+    // 0 for a draw or when the side to move is mated
+    int plies;
+};
+
+// Distance to mate tables of the endings with few pieces, one table
+// per material, like KQvK or KRvKN. Every position of a table has a
+// byte with its distance to mate in plies, so a probe is a single
+// lookup. The tables are built by retrograde analysis and written to
+// a directory, one file per table, which is memory mapped when opened.
+// Probing only reads the tables, so the threads can share them.
+//
+// Positions are stored with the stronger side as white and its king on
+// the files a to d, other positions are mirrored to them. Castling and
+// en passant are not in the tables, positions with them aren't probed.
+class Tablebases {
+public:
+    // Most pieces of a position in the tables, kings included
+    static constexpr int MAX_PIECES = 4;
+
+    Tablebases();
+    ~Tablebases();
+
+    Tablebases(const Tablebases&) = delete;
+    Tablebases& operator=(const Tablebases&) = delete;
+
+    // Maps the tables of the directory, missing tables are skipped
+    // Returns false if the directory can't be read
+    bool open(const string& directory);
+
+    // Builds the tables of up to maxPieces pieces that the directory
+    // doesn't have yet, with the given number of threads. Smaller tables
+    // are built first, since captures and promotions lead into them.
+    // The progress is printed. Returns false if a table can't be written
+    bool generate(const string& directory, int maxPieces, int threads);
+
+    // Number of tables that are mapped
+    int size() const;
+
+    // Looks the position up
+    // Returns false if the tables don't have the position
+    bool probe(const Board& board, Color turn, TablebaseResult& result) const;
+
+    // Returns the move that keeps the best outcome and reaches it the
+    // fastest, or the slowest when losing, with the result of the
+    // position. Returns NO_MOVE if the tables don't have the position
+    Move bestMove(const Board& board, Color turn, TablebaseResult& result) const;
+private:
+    struct Table;
+
+    // Table of a material, and if its colors are swapped from the board
+    struct Lookup {
+        const Table* table = nullptr;
+        bool swapped = false;
+    };
+
+    // Finds the table and the index of a position
+    // Castling rights and the en passant square are ignored
+    // Returns false if no table has the position
+    bool locate(const Board& board, Color turn, const Table*& table, size_t& index) const;
+
+    // Reads the distance to mate byte of a position, tables
+    // that are being built are written by other threads
+    static uint8_t value(const Table& table, size_t index);
+
+    // Distance to mate byte of a position, positions without a table
+    // are draws. With an en passant square, the capture is searched
+    uint8_t distance(const Board& board, Color turn) const;
+
+    // Sets best to the distance to mate byte of the best en passant
+    // capture of the position, and otherMoves to whether it has other
+    // legal moves. Returns false if there is no capture
+    bool enPassantDistance(const Board& board, Color turn, uint8_t& best, bool& otherMoves) const;
+
+    // Sets the board up from an index of the table
+    // Returns false if the index isn't a legal position
+    static bool decode(const Table& table, size_t index, Board& board, Color& turn);
+
+    // Maps the file of the table, returns false if there is none
+    static bool map(Table& table, const string& path);
+
+    // Writes the built table to its file
+    static bool write(const Table& table, const string& path);
+
+    // Builds the distance to mate of every position of the table
+    void build(Table& table, int threads);
+
+    // Checks a position whose moves may have been solved since the last
+    // round, returns true if it is solved at the given distance
+    bool solve(Board& board, Color turn, int distance) const;
+
+    // Marks the positions that lead to the solved position with a move
+    // that isn't a capture or a promotion, so the next round checks them
+    void markPredecessors(Board& board, Color turn, const Table& table, vector<uint64_t>& marks) const;
+
+    // Points the lookups of the table's material and its
+    // colors swapped material to the table
+    void registerTable(const Table& table);
+
+    // Every material of up to MAX_PIECES pieces, in building order
+    vector<unique_ptr<Table>> tables_;
+
+    // Table of every material key, see the source for the keys
+    vector<Lookup> lookups_;
+};
+
+
+#endif //CHESS_TABLEBASES_H
@@ -0,0 +1,108 @@
+/* Chess --- transpositionTable.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "transpositionTable.h"
+
+// Layout of the 64 bits of data in a slot
+// move  : 16 bits | score      : 16 bits
+// depth : 8 bits  | bound      : 2 bits  | generation : 8 bits
+namespace {
+    uint64_t pack(const int depth, const Bound bound, const int score, const Move move, const uint8_t generation) {
+        return static_cast<uint64_t>(move.data())
+            | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+            | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32
+            | static_cast<uint64_t>(bound) << 40
+            | static_cast<uint64_t>(generation) << 42;
+    }
+
+    TTEntry unpack(const uint64_t data) {
+        return {
+            static_cast<int8_t>(data >> 32 & 0xFF),
+            static_cast<Bound>(data >> 40 & 3),
+            static_cast<int16_t>(data >> 16 & 0xFFFF),
+            Move::fromData(static_cast<uint16_t>(data))
+        };
+    }
+
+    uint8_t generationOf(const uint64_t data) {
+        return static_cast<uint8_t>(data >> 42);
+    }
+}
+
+HashStats& HashStats::operator+=(const HashStats& other) {
+    probes += other.probes;
+    hits += other.hits;
+    stores += other.stores;
+    overwrites += other.overwrites;
+    return *this;
+}
+
+TranspositionTable::TranspositionTable(const size_t megabytes) {
+    mask_ = 0;
+    generation_ = 0;
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(const size_t megabytes) {
+    // The slot count is rounded down to a power of two,
+    // so the index is a mask of the key
+    size_t count = 1;
+    while (count * 2 * sizeof(Slot) <= megabytes * 1024 * 1024) count *= 2;
+
+    slots_ = make_unique<Slot[]>(count);
+    mask_ = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i <= mask_; i++) {
+        slots_[i].check.store(0, memory_order_relaxed);
+        slots_[i].data.store(0, memory_order_relaxed);
+    }
+}
+
+void TranspositionTable::newSearch() {
+    generation_++;
+}
+
+bool TranspositionTable::probe(const uint64_t key, TTEntry& entry) const {
+    const Slot& slot = slots_[key & mask_];
+    const uint64_t data = slot.data.load(memory_order_relaxed);
+    const uint64_t check = slot.check.load(memory_order_relaxed);
+
+    if ((check ^ data) != key || data == 0) return false;
+    entry = unpack(data);
+    return true;
+}
+
+bool TranspositionTable::store(const uint64_t key, const int depth, const Bound bound,
+                               const int score, const Move move) {
+    Slot& slot = slots_[key & mask_];
+    const uint64_t oldData = slot.data.load(memory_order_relaxed);
+    const uint64_t oldKey = slot.check.load(memory_order_relaxed) ^ oldData;
+    const bool samePosition = oldKey == key;
+    const bool occupied = oldData != 0;
+
+    if (occupied) {
+        const TTEntry old = unpack(oldData);
+
+        // Deeper results of the current search are kept
+        if (!samePosition && generationOf(oldData) == generation_ && old.depth > depth) return false;
+        if (samePosition && old.depth > depth + 2 && bound != BOUND_EXACT) return false;
+    }
+
+    // Keep the old best move when the new result has none
+    Move storedMove = move;
+    if (samePosition && move == NO_MOVE) storedMove = unpack(oldData).move;
+
+    const uint64_t data = pack(depth, bound, score, storedMove, generation_);
+    slot.data.store(data, memory_order_relaxed);
+    slot.check.store(key ^ data, memory_order_relaxed);
+    return occupied && !samePosition;
+}
+
+size_t TranspositionTable::megabytes() const {
+    return (mask_ + 1) * sizeof(Slot) / (1024 * 1024);
+}
@@ -0,0 +1,80 @@
+/* Chess --- transpositionTable.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_TRANSPOSITIONTABLE_H
+#define CHESS_TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "boardFunctions.h"
+
+using namespace std;
+
+// What the stored score says about the real score
+enum Bound {BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT};
+
+// A decoded entry of the table
+struct TTEntry {
+    int depth;
+    Bound bound;
+    int score;
+    Move move;
+};
+
+// Counters of the table usage, collected by the search threads
+struct HashStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t overwrites = 0;
+
+    double hitRate() const { return probes ? static_cast<double>(hits) / probes : 0; }
+    double missRate() const { return probes ? 1 - hitRate() : 0; }
+    double overwriteRate() const { return stores ? static_cast<double>(overwrites) / stores : 0; }
+
+    HashStats& operator+=(const HashStats& other);
+};
+
+// Fixed size hash table of searched positions, shared by all the
+// search threads without locks. Every slot keeps the key XORed with
+// the data, so a slot torn by two threads writing at once fails the
+// key check and reads as a miss instead of returning wrong data.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes);
+
+    // Reallocates the table, all the entries are lost
+    void resize(size_t megabytes);
+
+    // Removes all the entries
+    void clear();
+
+    // Starts a new search, entries of older
+    // searches are replaced first
+    void newSearch();
+
+    // Looks the key up, returns false if it isn't stored
+    bool probe(uint64_t key, TTEntry& entry) const;
+
+    // Stores a search result
+    // Returns true if an entry of another position was replaced
+    bool store(uint64_t key, int depth, Bound bound, int score, Move move);
+
+    // Size of the table in megabytes
+    size_t megabytes() const;
+private:
+    struct Slot {
+        atomic<uint64_t> check;
+        atomic<uint64_t> data;
+    };
+
+    unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    uint8_t generation_;
+};
+
+
+#endif //CHESS_TRANSPOSITIONTABLE_H
@@ -0,0 +1,328 @@
+/* Chess --- uci.cpp
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#include "uci.h"
+#include "chessBot.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace BoardFunctions;
+using namespace std::chrono;
+
+namespace {
+    const char* STARTING_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    // Time kept back for the communication with the GUI
+    const int64_t MOVE_OVERHEAD = 30;
+
+    // Moves the remaining time is split between when
+    // the GUI doesn't say how many moves are left
+    const int64_t DEFAULT_MOVES_TO_GO = 30;
+
+    // The I/O thread and the search thread both write lines,
+    // so every line is written whole under this lock
+    mutex outputMutex;
+
+    void send(const string& line) {
+        lock_guard<mutex> lock(outputMutex);
+        cout << line << endl;
+    }
+
+    // State of the engine between commands
+    struct Session {
+        explicit Session(const size_t hashMegabytes) : bot(hashMegabytes) {}
+
+        ChessBot bot;
+        Board board{};
+        Color turn = WHITE;
+
+        // The running search, if any
+        thread worker;
+        atomic<bool> stop = false;
+        atomic<bool> ponder = false;
+        bool infinite = false;
+
+        // Sends the statistics of every search as JSON
+        bool stats = false;
+
+        // Parts of the selective search that are used
+        PruningOptions pruning;
+
+        // Best moves every search reports a line of
+        int multiPv = 1;
+
+        // Wakes the worker up when a finished search
+        // waits for stop or ponderhit before answering
+        mutex waitMutex;
+        condition_variable wake;
+
+        // Start of the running search, for the nps and time
+        steady_clock::time_point startTime;
+
+        // Line of the last completed depth, its second move
+        // is the move the bot would like to ponder on
+        vector<Move> pv;
+    };
+
+    // Converts a score to centipawns, or to the moves left until mate
+    string formatScore(const int score) {
+        const int mate = movesToMate(score);
+        if (mate != 0) return "mate " + to_string(mate);
+
+        // A pawn is 10 in the evaluation and 100 centipawns
+        return "cp " + to_string(score * 10);
+    }
+
+    // position [startpos | fen <FEN>] [moves <move> ...]
+    void setPosition(Session& session, istringstream& stream) {
+        string token;
+        string fen;
+        stream >> token;
+        if (token == "startpos") {
+            fen = STARTING_FEN;
+            stream >> token;
+        }
+        else if (token == "fen") {
+            while (stream >> token && token != "moves") fen += token + " ";
+        }
+
+        if (!loadFen(session.board, fen, session.turn)) {
+            send("info string invalid position");
+            loadFen(session.board, STARTING_FEN, session.turn);
+            return;
+        }
+
+        while (stream >> token) {
+            const Move move = convertNotationToMove(session.board, token, session.turn);
+            if (move == NO_MOVE) {
+                send("info string illegal move " + token);
+                return;
+            }
+            makeMove(session.board, move);
+            session.turn = session.turn == WHITE ? BLACK : WHITE;
+        }
+    }
+
+    // Prints the result of a completed depth, with a line
+    // for every root move of a MultiPV search
+    void sendInfo(Session& session, const SearchInfo& info) {
+        session.pv = info.pv;
+
+        const int64_t elapsed = duration_cast<milliseconds>(steady_clock::now() - session.startTime).count();
+        const string stats = " nodes " + to_string(info.nodes) +
+                             " nps " + to_string(info.nodes * 1000 / max<int64_t>(elapsed, 1)) +
+                             " time " + to_string(elapsed) + " pv";
+        if (info.lines.size() <= 1) {
+            string line = "info depth " + to_string(info.depth) + " score " + formatScore(info.score) + stats;
+            for (const Move move : info.pv) line += " " + convertMoveToNotation(move);
+            send(line);
+            return;
+        }
+        for (size_t i = 0; i < info.lines.size(); i++) {
+            string line = "info depth " + to_string(info.depth) + " multipv " + to_string(i + 1) +
+                          " score " + formatScore(info.lines[i].score) + stats;
+            for (const Move move : info.lines[i].pv) line += " " + convertMoveToNotation(move);
+            send(line);
+        }
+    }
+
+    // Tells the running search to stop and waits for it
+    void stopSearch(Session& session) {
+        {
+            lock_guard<mutex> lock(session.waitMutex);
+            session.stop = true;
+            session.ponder = false;
+        }
+        session.wake.notify_all();
+        if (session.worker.joinable()) session.worker.join();
+    }
+
+    // go [ponder] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>]
+    //    [movetime <ms>] [depth <n>] [nodes <n>] [infinite]
+    void startSearch(Session& session, istringstream& stream) {
+        SearchLimits limits;
+        int64_t time[2] = {0, 0};
+        int64_t increment[2] = {0, 0};
+        int64_t movesToGo = DEFAULT_MOVES_TO_GO;
+        bool ponder = false;
+        bool infinite = false;
+
+        string token;
+        while (stream >> token) {
+            if (token == "ponder") ponder = true;
+            else if (token == "infinite") infinite = true;
+            else if (token == "wtime") stream >> time[WHITE];
+            else if (token == "btime") stream >> time[BLACK];
+            else if (token == "winc") stream >> increment[WHITE];
+            else if (token == "binc") stream >> increment[BLACK];
+            else if (token == "movestogo") stream >> movesToGo;
+            else if (token == "movetime") stream >> limits.milliseconds;
+            else if (token == "depth") stream >> limits.depth;
+            else if (token == "nodes") stream >> limits.nodes;
+        }
+        limits.depth = clamp(limits.depth, 1, MAX_PLY - 1);
+        limits.multiPv = session.multiPv;
+
+        // A share of the remaining time plus most of the increment,
+        // but never so much that the clock could run out
+        const int64_t remaining = time[session.turn];
+        if (limits.milliseconds > 0) {
+            limits.milliseconds = max<int64_t>(1, limits.milliseconds - MOVE_OVERHEAD);
+        }
+        else if (remaining > 0 && !infinite) {
+            const int64_t budget = remaining / max<int64_t>(movesToGo, 1) + increment[session.turn] * 3 / 4;
+            limits.milliseconds = max<int64_t>(1, min(budget, remaining / 2 - MOVE_OVERHEAD));
+        }
+
+        session.stop = false;
+        session.ponder = ponder;
+        session.infinite = infinite;
+        session.pv.clear();
+        limits.stop = &session.stop;
+        limits.ponder = &session.ponder;
+        session.startTime = steady_clock::now();
+
+        session.worker = thread([&session, limits] {
+            const auto [score, move] = session.bot.search(session.board, session.turn, limits);
+            if (session.bot.playedFromBook()) send("info string book move");
+
+            // A tablebase move comes without a search, its score is exact
+            if (session.bot.playedFromTablebase()) {
+                send("info string tablebase move");
+                sendInfo(session, {0, session.turn == WHITE ? score : -score, 0, {move}, {}});
+            }
+
+            if (session.stats) send("info string stats " + session.bot.stats().toJson());
+
+            // The best move of an infinite or pondering search is
+            // only sent once the GUI asks for it
+            {
+                unique_lock<mutex> lock(session.waitMutex);
+                session.wake.wait(lock, [&session] {
+                    return session.stop || (!session.infinite && !session.ponder);
+                });
+            }
+
+            if (move == NO_MOVE) {
+                send("bestmove 0000");
+                return;
+            }
+            string line = "bestmove " + convertMoveToNotation(move);
+            if (session.pv.size() >= 2 && session.pv[0] == move) {
+                line += " ponder " + convertMoveToNotation(session.pv[1]);
+            }
+            send(line);
+        });
+    }
+
+    // setoption name <name> value <value>
+    void setOption(Session& session, istringstream& stream, const OpeningBook* book,
+                   const BookSelection bookSelection, const Tablebases* tablebases, const Network* network) {
+        string token;
+        string name;
+        string value;
+        stream >> token;
+        while (stream >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+        stream >> value;
+
+        try {
+            if (name == "Hash") session.bot.setHashSize(max(1, stoi(value)));
+            else if (name == "Threads") session.bot.setThreads(max(1, stoi(value)));
+            else if (name == "PawnHash") session.bot.setPawnHashSize(max(1, stoi(value)));
+            else if (name == "MultiPV") session.multiPv = clamp(stoi(value), 1, MAX_MOVES);
+            else if (name == "OwnBook") session.bot.setBook(value == "true" ? book : nullptr, bookSelection);
+            else if (name == "UseTablebases") session.bot.setTablebases(value == "true" ? tablebases : nullptr);
+            else if (name == "SearchStats") session.stats = value == "true";
+            else if (name == "NullMove") session.pruning.nullMove = value == "true";
+            else if (name == "LateMoveReductions") session.pruning.lateMoveReductions = value == "true";
+            else if (name == "FutilityPruning") session.pruning.futility = value == "true";
+            else if (name == "UseNNUE") session.bot.setNetwork(value == "true" ? network : nullptr);
+            session.bot.setPruning(session.pruning);
+        } catch (exception const& _) {
+            send("info string invalid value for " + name);
+        }
+    }
+}
+
+namespace Uci {
+    void run(const size_t hashMegabytes, const int threads, const OpeningBook* book,
+             const BookSelection bookSelection, const Tablebases* tablebases, const Network* network,
+             const PruningOptions& pruning, const size_t pawnHashKilobytes) {
+        Session session(hashMegabytes);
+        session.pruning = pruning;
+        session.bot.setThreads(threads);
+        session.bot.setBook(book, bookSelection);
+        session.bot.setTablebases(tablebases);
+        session.bot.setNetwork(network);
+        session.bot.setPruning(pruning);
+        session.bot.setPawnHashSize(pawnHashKilobytes);
+        session.bot.setInfoCallback([&session](const SearchInfo& info) { sendInfo(session, info); });
+        loadFen(session.board, STARTING_FEN, session.turn);
+
+        string line;
+        while (getline(cin, line)) {
+            istringstream stream(line);
+            string command;
+            stream >> command;
+
+            if (command == "uci") {
+                send("id name Chess Bot");
+                send("id author Kaan Pide");
+                send("option name Hash type spin default " + to_string(hashMegabytes) + " min 1 max 65536");
+                send("option name Threads type spin default " + to_string(threads) + " min 1 max 256");
+                send("option name PawnHash type spin default " + to_string(pawnHashKilobytes) + " min 1 max 65536");
+                send("option name MultiPV type spin default 1 min 1 max " + to_string(MAX_MOVES));
+                send("option name Ponder type check default false");
+                send("option name SearchStats type check default false");
+                send("option name NullMove type check default " + string(pruning.nullMove ? "true" : "false"));
+                send("option name LateMoveReductions type check default " +
+                     string(pruning.lateMoveReductions ? "true" : "false"));
+                send("option name FutilityPruning type check default " + string(pruning.futility ? "true" : "false"));
+                if (book) send("option name OwnBook type check default true");
+                if (tablebases) send("option name UseTablebases type check default true");
+                if (network) send("option name UseNNUE type check default true");
+                send("uciok");
+            }
+            else if (command == "isready") {
+                send("readyok");
+            }
+            else if (command == "setoption") {
+                stopSearch(session);
+                setOption(session, stream, book, bookSelection, tablebases, network);
+            }
+            else if (command == "ucinewgame") {
+                stopSearch(session);
+                session.bot.clearHash();
+            }
+            else if (command == "position") {
+                stopSearch(session);
+                setPosition(session, stream);
+            }
+            else if (command == "go") {
+                stopSearch(session);
+                startSearch(session, stream);
+            }
+            else if (command == "stop") {
+                stopSearch(session);
+            }
+            else if (command == "ponderhit") {
+                {
+                    lock_guard<mutex> lock(session.waitMutex);
+                    session.ponder = false;
+                }
+                session.wake.notify_all();
+            }
+            else if (command == "quit") {
+                break;
+            }
+        }
+        stopSearch(session);
+    }
+}
@@ -0,0 +1,31 @@
+/* Chess --- uci.h
+ * Author: Kaan Pide
+ * Date  : 18.10.2026
+ */
+
+#ifndef CHESS_UCI_H
+#define CHESS_UCI_H
+
+#include <cstddef>
+#include "chessBot.h"
+#include "openingBook.h"
+#include "tablebases.h"
+
+// Namespace that holds the Universal Chess Interface front end,
+// so the bot can be used by chess GUIs and match runners
+namespace Uci {
+    // Reads UCI commands from the standard input until quit
+    // Searches run on a worker thread, so commands like stop
+    // and isready are answered while the bot is thinking
+    // The book, if any, is used while the OwnBook option is on,
+    // the tablebases while the UseTablebases option is on,
+    // and the network while the UseNNUE option is on
+    // pruning sets the defaults of the selective search options,
+    // and pawnHashKilobytes the default of the PawnHash option
+    void run(size_t hashMegabytes, int threads, const OpeningBook* book, BookSelection bookSelection,
+             const Tablebases* tablebases, const Network* network, const PruningOptions& pruning,
+             size_t pawnHashKilobytes);
+}
+
+
+#endif //CHESS_UCI_H